@@ -0,0 +1,63 @@
+#include <zephyrus/macro.hpp>
+
+#include "benchmark.hpp"
+
+// Worst-case latency of recording a frame fix on every frame, which is what a long EveryFrame recording does
+// on the game thread. The chunked fix columns are compared with the std::vector<FrameFix> that Macro used
+// before, whose growth copies every fix recorded so far.
+//
+// Usage: append-latency [fix count = 20000000]
+
+namespace {
+    using namespace zephyrus;
+
+    struct Latencies {
+        double total{}; // Seconds for every append
+        std::vector<float> samples; // Microseconds of each append
+    };
+
+    template<typename Append>
+    Latencies measure(size_t count, Append append) {
+        Latencies latencies;
+        latencies.samples.reserve(count);
+        auto start = Benchmark::Clock::now();
+        for (size_t i = 0; i < count; i++) {
+            auto before = Benchmark::Clock::now();
+            append(static_cast<uint32_t>(i));
+            latencies.samples.push_back(std::chrono::duration<float, std::micro>(Benchmark::Clock::now() - before).count());
+        }
+        latencies.total = Benchmark::secondsSince(start);
+        return latencies;
+    }
+
+    void print(const char *name, Latencies latencies) {
+        size_t stalls = std::count_if(latencies.samples.begin(), latencies.samples.end(), [](float sample) {
+            return sample > 1000;
+        });
+        std::sort(latencies.samples.begin(), latencies.samples.end());
+        std::printf("%-28s total %6.2f s  p50 %6.3f us  p99.99 %8.3f us  max %10.1f us  appends over 1 ms: %zu\n",
+                    name, latencies.total, Benchmark::getPercentile(latencies.samples, 0.5),
+                    Benchmark::getPercentile(latencies.samples, 0.9999), latencies.samples.back(), stalls);
+    }
+}
+
+int main(int argc, char **argv) {
+    size_t count = Benchmark::getArgument(argc, argv, 1, 20000000);
+    Benchmark::printMachine();
+    std::printf("%zu fixes, one per frame\n", count);
+
+    {
+        std::vector<Macro::FrameFix> frameFixes;
+        print("std::vector<FrameFix>", measure(count, [&](uint32_t frame) {
+            frameFixes.emplace_back(frame, Macro::FrameFix::PlayerData{float(frame), 1.f, 2.0, 3.f});
+        }));
+    }
+
+    {
+        Macro macro;
+        print("Macro::addFrameFix", measure(count, [&](uint32_t frame) {
+            macro.addFrameFix(frame, {float(frame), 1.f, 2.0, 3.f});
+        }));
+    }
+    return 0;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+/// @brief Helpers shared by the benchmarks
+namespace zephyrus::Benchmark {
+    using Clock = std::chrono::steady_clock;
+
+    /// @brief Returns the seconds elapsed since the specified time
+    inline double secondsSince(Clock::time_point start) {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    /// @brief Runs the function several times and returns its fastest run, in seconds
+    template<typename Function>
+    double bestOf(int runs, Function function) {
+        double best = 0;
+        for (int run = 0; run < runs; run++) {
+            auto start = Clock::now();
+            function();
+            double seconds = secondsSince(start);
+            best = run == 0 ? seconds : std::min(best, seconds);
+        }
+        return best;
+    }
+
+    /// @brief Returns the numeric argument at the specified position, or the fallback if there is none
+    inline size_t getArgument(int argc, char **argv, int position, size_t fallback) {
+        return position < argc ? std::strtoull(argv[position], nullptr, 10) : fallback;
+    }
+
+    /// @brief Returns the peak resident memory of the process in MB, or 0 where it is not known
+    /// @note The peak never goes down, so paths that are compared on memory have to run in separate processes
+    inline double getPeakMemory() {
+#ifdef _WIN32
+        return 0;
+#else
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+        return usage.ru_maxrss / 1e6; // Bytes
+#else
+        return usage.ru_maxrss / 1e3; // Kilobytes
+#endif
+#endif
+    }
+
+    /// @brief Returns a path in the temporary directory for the files written by a benchmark
+    inline std::filesystem::path getTemporaryPath(const std::string &name) {
+        return std::filesystem::temp_directory_path() / ("zephyrus-benchmark-" + name);
+    }
+
+    /// @brief Prints the number of cores, since every measurement depends on the machine
+    inline void printMachine() {
+        std::printf("hardware threads: %u\n", std::thread::hardware_concurrency());
+    }
+
+    /// @brief Returns the value at the specified fraction of sorted samples (0.5 for the median)
+    template<typename T>
+    T getPercentile(const std::vector<T> &sorted, double fraction) {
+        return sorted[std::min(sorted.size() - 1, static_cast<size_t>(fraction * sorted.size()))];
+    }
+}
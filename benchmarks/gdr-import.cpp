@@ -0,0 +1,118 @@
+#include <zephyrus/formats/gdreplay.hpp>
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "../thirdparty/json.hpp"
+#include "benchmark.hpp"
+#include "file-reader.hpp"
+
+// Time and peak memory of GDReplay imports. A replay with a fix on every input is written as MessagePack (.gdr)
+// and JSON (.gdr.json), then read in a child process per reader, since the peak memory of a process never goes
+// down. "sax" is formats::GDR::readFromFile, "dom" parses the whole file into an nlohmann::json document and walks
+// a copy of its inputs, like the importer did before it, and "file" only reads the bytes for the baseline.
+//
+// Usage: gdr-import [input count = 500000]
+//        gdr-import read <sax|dom|file> <path> (a single measurement, run by the first form)
+
+namespace {
+    using namespace zephyrus;
+
+    /// @brief Reads a replay the way the importer did before it parsed with SAX callbacks
+    bool readDocument(const std::filesystem::path &path, Macro &macro) {
+        std::vector<uint8_t> data;
+        if (!FileReader::readWholeFile(path, data) || data.empty()) {
+            return false;
+        }
+
+        nlohmann::json json = data[0] == '{' ? nlohmann::json::parse(data, nullptr, false)
+                                             : nlohmann::json::from_msgpack(data, true, false);
+        if (json.is_discarded()) {
+            return false;
+        }
+
+        try {
+            auto inputs = json["inputs"];
+            for (auto &input: inputs) {
+                auto frame = input["frame"].get<uint32_t>();
+                macro.addFrame(frame, input["2p"].get<bool>(), static_cast<PlayerButton>(input["btn"].get<uint8_t>()),
+                               input["down"].get<bool>());
+                if (!input.contains("mhr_meta")) continue;
+                macro.addFrameFix(frame, {input["mhr_x"].get<float>(), input["mhr_y"].get<float>(),
+                                          input["mhr_yvel"].get<double>(), 0});
+            }
+        } catch (const nlohmann::json::exception &) {
+            return false;
+        }
+        return true;
+    }
+
+    int measure(const char *reader, const std::filesystem::path &path) {
+        Macro macro;
+        std::vector<uint8_t> data;
+        auto start = Benchmark::Clock::now();
+        bool read = false;
+        if (std::strcmp(reader, "sax") == 0) {
+            read = formats::GDR::readFromFile(path, macro);
+        } else if (std::strcmp(reader, "dom") == 0) {
+            read = readDocument(path, macro);
+        } else if (std::strcmp(reader, "file") == 0) {
+            read = FileReader::readWholeFile(path, data);
+        }
+        double seconds = Benchmark::secondsSince(start);
+        if (!read) {
+            std::printf("%s: could not read %s\n", reader, path.string().c_str());
+            return 1;
+        }
+
+        const char *encoding = path.extension() == ".json" ? "JSON" : "MessagePack";
+        std::printf("%-4s %-11s %8.1f MB  %6.3f s  %8.1f MB peak  %zu inputs\n", reader, encoding,
+                    std::filesystem::file_size(path) / 1e6, seconds, Benchmark::getPeakMemory(),
+                    macro.getFrames().size());
+        return 0;
+    }
+
+    Macro makeMacro(size_t inputCount) {
+        Macro macro;
+        for (uint32_t i = 0; i < inputCount; i++) {
+            uint32_t frame = i * 2 + 1;
+            macro.addFrame(frame, false, PlayerButton::Jump, i % 2 == 0);
+            macro.addFrameFix(frame, {frame * 0.3f, 105.f + i % 90, (i % 40) * 0.5 - 10.0, 0});
+        }
+        return macro;
+    }
+}
+
+int main(int argc, char **argv) {
+    if (argc == 4 && std::strcmp(argv[1], "read") == 0) {
+        return measure(argv[2], argv[3]);
+    }
+
+    size_t inputCount = Benchmark::getArgument(argc, argv, 1, 500000);
+    Benchmark::printMachine();
+    std::printf("%zu inputs with a fix each, one process per line\n", inputCount);
+
+    auto messagePack = Benchmark::getTemporaryPath("gdr.gdr");
+    auto json = Benchmark::getTemporaryPath("gdr.gdr.json");
+    if (!formats::GDR::writeToFile(makeMacro(inputCount), messagePack) ||
+        !formats::GDR::writeToFile(makeMacro(inputCount), json)) {
+        std::printf("could not write the replays\n");
+        return 1;
+    }
+
+    int result = 0;
+    for (const auto &path: {messagePack, json}) {
+        for (const char *reader: {"file", "sax", "dom"}) {
+            std::string command = "\"" + std::string(argv[0]) + "\" read " + reader + " \"" + path.string() + "\"";
+            std::fflush(stdout);
+            if (std::system(command.c_str()) != 0) {
+                result = 1;
+            }
+        }
+    }
+
+    std::filesystem::remove(messagePack);
+    std::filesystem::remove(json);
+    return result;
+}
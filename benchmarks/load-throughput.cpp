@@ -0,0 +1,117 @@
+#include <zephyrus.hpp>
+
+#include <fstream>
+
+#include "benchmark.hpp"
+
+// Load throughput of the native format, in MB/s and records/s. A macro with a fix on every frame is written
+// as version 2, version 3 and compressed version 3, then read back with readFromFile. Version 2 is also read
+// one field at a time through std::ifstream, like readFromFile did before it read whole files.
+//
+// Usage: load-throughput [fix count = 8000000] [action count = 2000000]
+
+namespace {
+    using namespace zephyrus;
+
+    template<typename T>
+    T readField(std::ifstream &file) {
+        T value{}; // The files are little endian, like the machines this runs on
+        file.read(reinterpret_cast<char *>(&value), sizeof(T));
+        return value;
+    }
+
+    Macro::FrameFix::PlayerData readPlayerData(std::ifstream &file) {
+        Macro::FrameFix::PlayerData data{};
+        data.x = readField<float>(file);
+        data.y = readField<float>(file);
+        data.ySpeed = readField<double>(file);
+        data.rotation = readField<float>(file);
+        return data;
+    }
+
+    /// @brief Reads a version 2 file with a stream read per field, without reserving
+    bool readPerField(const std::filesystem::path &path, Macro &macro) {
+        std::ifstream file(path, std::ios::binary);
+        auto magic = readField<uint16_t>(file);
+        auto version = readField<uint8_t>(file);
+        readField<uint32_t>(file); // Recorded FPS
+        auto actionCount = readField<uint32_t>(file);
+        auto frameFixCount = readField<uint32_t>(file);
+        if (!file || magic != 0x525A || version != 2) {
+            return false;
+        }
+
+        for (uint32_t i = 0; i < actionCount; i++) {
+            auto frame = readField<uint32_t>(file);
+            macro.addFrame(frame, readField<uint8_t>(file));
+        }
+        for (uint32_t i = 0; i < frameFixCount; i++) {
+            auto frame = readField<uint32_t>(file);
+            auto player1 = readPlayerData(file);
+            if (readField<bool>(file)) {
+                macro.addFrameFix(frame, player1, readPlayerData(file));
+            } else {
+                macro.addFrameFix(frame, player1);
+            }
+        }
+        return static_cast<bool>(file);
+    }
+
+    Macro makeMacro(size_t frameFixCount, size_t actionCount) {
+        Macro macro;
+        size_t actionEvery = std::max<size_t>(frameFixCount / std::max<size_t>(actionCount, 1), 1);
+        for (uint32_t frame = 0; frame < frameFixCount; frame++) {
+            if (frame % actionEvery == 0) {
+                macro.addFrame(frame, false, PlayerButton::Jump, frame / actionEvery % 2 == 0);
+            }
+            macro.addFrameFix(frame, {frame * 0.1f, 105.f + frame % 90, (frame % 40) * 0.5 - 10.0, float(frame % 360)});
+        }
+        return macro;
+    }
+
+    template<typename Read>
+    void measure(const char *name, const std::filesystem::path &path, Read read) {
+        size_t records = 0;
+        double seconds = Benchmark::bestOf(3, [&]() {
+            Macro macro;
+            if (!read(path, macro)) {
+                std::printf("%s: could not read %s\n", name, path.string().c_str());
+                std::exit(1);
+            }
+            records = macro.getFrames().size() + macro.getFrameFixes().size();
+        });
+        double megabytes = std::filesystem::file_size(path) / 1e6;
+        std::printf("%-30s %8.1f MB  %6.3f s  %8.1f MB/s  %6.2f M records/s\n", name, megabytes, seconds,
+                    megabytes / seconds, records / seconds / 1e6);
+    }
+}
+
+int main(int argc, char **argv) {
+    size_t frameFixCount = Benchmark::getArgument(argc, argv, 1, 8000000);
+    size_t actionCount = Benchmark::getArgument(argc, argv, 2, 2000000);
+    Benchmark::printMachine();
+    std::printf("%zu fixes, %zu actions, best of 3\n", frameFixCount, actionCount);
+
+    auto version2 = Benchmark::getTemporaryPath("load-v2.zr");
+    auto version3 = Benchmark::getTemporaryPath("load-v3.zr");
+    auto compressed = Benchmark::getTemporaryPath("load-v3-lz.zr");
+    {
+        Macro macro = makeMacro(frameFixCount, actionCount);
+        if (!writeToFile(macro, version2, 2) || !writeToFile(macro, version3, 3) ||
+            !writeToFile(macro, compressed, 3, MacroFileCodec::LZ)) {
+            std::printf("could not write the macros\n");
+            return 1;
+        }
+    }
+
+    measure("version 2, a read per field", version2, readPerField);
+    auto read = [](const std::filesystem::path &path, Macro &macro) { return readFromFile(path, macro); };
+    measure("version 2, readFromFile", version2, read);
+    measure("version 3, readFromFile", version3, read);
+    measure("version 3 LZ, readFromFile", compressed, read);
+
+    std::filesystem::remove(version2);
+    std::filesystem::remove(version3);
+    std::filesystem::remove(compressed);
+    return 0;
+}
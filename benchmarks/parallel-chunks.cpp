@@ -0,0 +1,68 @@
+#include <zephyrus.hpp>
+
+#include "benchmark.hpp"
+#include "parallel.hpp"
+
+// How loading and saving version 3 files scale with the number of worker threads that decode and encode
+// the chunks. The worker count is forced, so every count runs on any machine, but only a machine with at
+// least that many cores shows the speedup.
+//
+// Usage: parallel-chunks [fix count = 8000000] [most workers = max(cores - 1, 3)]
+
+namespace {
+    using namespace zephyrus;
+
+    Macro makeMacro(size_t frameFixCount) {
+        Macro macro;
+        for (uint32_t frame = 0; frame < frameFixCount; frame++) {
+            if (frame % 4 == 0) {
+                macro.addFrame(frame, false, PlayerButton::Jump, frame % 8 == 0);
+            }
+            macro.addFrameFix(frame, {frame * 0.1f, 105.f + frame % 90, (frame % 40) * 0.5 - 10.0, float(frame % 360)});
+        }
+        return macro;
+    }
+}
+
+int main(int argc, char **argv) {
+    size_t frameFixCount = Benchmark::getArgument(argc, argv, 1, 8000000);
+    unsigned cores = std::thread::hardware_concurrency();
+    size_t mostWorkers = Benchmark::getArgument(argc, argv, 2, std::max(cores > 1 ? cores - 1 : 0u, 3u));
+    Benchmark::printMachine();
+    if (cores < 2) {
+        std::printf("only one hardware thread: workers add overhead here, measure the speedup on a multi-core machine\n");
+    }
+    std::printf("%zu fixes, %zu actions, best of 3\n", frameFixCount, frameFixCount / 4);
+
+    Macro macro = makeMacro(frameFixCount);
+    for (auto codec : {MacroFileCodec::None, MacroFileCodec::LZ}) {
+        auto path = Benchmark::getTemporaryPath("parallel-chunks.zr");
+        std::printf("%s\n", codec == MacroFileCodec::None ? "uncompressed" : "LZ");
+
+        double serialLoad = 0;
+        double serialSave = 0;
+        // 0 (the calling thread only), 1, 2, 4... up to the most workers
+        for (size_t workers = 0;; workers = std::min(workers ? workers * 2 : 1, mostWorkers)) {
+            Parallel::WorkerCountOverride = workers;
+            double save = Benchmark::bestOf(3, [&]() {
+                if (!writeToFile(macro, path, 3, codec)) std::exit(1);
+            });
+            double load = Benchmark::bestOf(3, [&]() {
+                Macro loaded;
+                if (!readFromFile(path, loaded)) std::exit(1);
+            });
+            if (workers == 0) {
+                serialLoad = load;
+                serialSave = save;
+            }
+            std::printf("  %2zu workers  load %6.3f s (%4.2fx)  save %6.3f s (%4.2fx)\n", workers, load,
+                        serialLoad / load, save, serialSave / save);
+            if (workers == mostWorkers) {
+                break;
+            }
+        }
+        std::filesystem::remove(path);
+    }
+    Parallel::WorkerCountOverride = SIZE_MAX;
+    return 0;
+}
@@ -5,9 +5,12 @@
 #include <vector>
 #include <cstdint>
 #include <functional>
+#include <memory>
 
 #include "zephyrus/macro.hpp"
 #include "zephyrus/file-io.hpp"
+#include "zephyrus/async-file-io.hpp"
+#include "zephyrus/macro-stream.hpp"
 
 /// @brief The main namespace for the Zephyrus Replay Bot
 namespace zephyrus {
@@ -28,8 +31,36 @@ namespace zephyrus {
     using RequestMacroFixMethod = std::function<Macro::FrameFix()>;
     using GetFrameMethod = std::function<uint32_t()>;
 
+    /// @brief Counters describing the work done by the playback tick
+    struct PlaybackStats {
+        uint64_t ticks{}; // Number of ticks processed while playing
+        uint64_t actionsDispatched{}; // Number of actions passed to the button handler
+        uint64_t fixesApplied{}; // Number of frame fixes passed to the fix handler
+        uint64_t entriesVisited{}; // Number of macro entries inspected by the tick (amortized O(1) per tick)
+        uint64_t seeks{}; // Number of times playback was repositioned with a binary search
+        uint64_t underruns{}; // Number of ticks that a streamed macro was not decoded far enough for
+    };
+
     /// @brief The main class for the Zephyrus Replay Bot
     class Zephyrus {
+    public:
+        Zephyrus() = default;
+
+        /// @brief Creates a bot whose own macro (the one it records into) allocates from the specified memory resource
+        explicit Zephyrus(std::pmr::memory_resource *resource) : m_macro(resource) {}
+
+        Zephyrus(const Zephyrus &) = delete;
+
+        Zephyrus &operator=(const Zephyrus &) = delete;
+
+        /// @brief Moves a bot, its playback cursor is rebuilt to point at the macro of the new bot
+        Zephyrus(Zephyrus &&other) noexcept;
+
+        /// @brief Moves a bot into this one
+        /// @note Not noexcept: when the bots use different memory resources, the macro is copied into the resource
+        /// of this bot (like std::pmr containers), which allocates
+        Zephyrus &operator=(Zephyrus &&other);
+
     public: // Control methods
         /// @brief Sets the state of the bot
         void setState(BotState state);
@@ -43,11 +74,38 @@ namespace zephyrus {
         /// @brief Returns the fix mode of the bot
         [[nodiscard]] BotFixMode getFixMode() const { return m_fixMode; }
 
-        /// @brief Set a macro for the bot to play
-        void setMacro(const Macro& macro) { m_macro = macro; }
+        /// @brief Set a macro for the bot to play (copies it)
+        void setMacro(const Macro& macro);
+
+        /// @brief Set a macro for the bot to play, taking ownership of it without copying
+        void setMacro(Macro&& macro);
+
+        /// @brief Set a macro for the bot to play, shared with other bots or tools without copying
+        /// @note The shared macro is never modified, it is copied the first time the bot needs to modify it
+        void setMacro(std::shared_ptr<const Macro> macro);
+
+        /// @brief Plays a macro file straight from disk instead of a macro in memory
+        /// @note Memory use stays the same for any macro length, see MacroStream. Recording still goes into
+        /// the macro of the bot, and setting a macro stops streaming.
+        /// @param capacity The number of batches decoded ahead of the current frame
+        /// @return True if the file can be streamed (a version 3 Zephyrus macro), false otherwise
+        bool streamMacro(const std::filesystem::path &path, size_t capacity = MacroStream::DefaultCapacity);
+
+        /// @brief Returns whether the bot plays a macro file straight from disk
+        [[nodiscard]] bool isStreaming() const { return m_stream != nullptr; }
 
         /// @brief Returns the macro that the bot is playing
-        [[nodiscard]] Macro& getMacro() { return m_macro; }
+        [[nodiscard]] const Macro& getMacro() const { return m_sharedMacro ? *m_sharedMacro : m_macro; }
+
+        /// @brief Returns the macro that the bot is playing, to modify it
+        /// @note Copies a shared macro first (see setMacro), so that modifying it does not affect other users
+        [[nodiscard]] Macro& editMacro();
+
+        /// @brief Moves the macro out of the bot (e.g. after recording), leaving it with an empty macro
+        [[nodiscard]] Macro takeMacro();
+
+        /// @brief Turns the macro of the bot into a shared one, so that others can use it without copying
+        [[nodiscard]] std::shared_ptr<const Macro> shareMacro();
 
         /// @brief Sets the method to handle button presses
         void setHandleButtonMethod(HandleButtonMethod method) { m_handleButtonMethod = std::move(method); }
@@ -76,15 +134,29 @@ namespace zephyrus {
         /// @brief Returns the method to get the current frame
         void setGetFrameMethod(GetFrameMethod method) { m_getFrameMethod = std::move(method); }
 
+        /// @brief Returns the counters collected by the playback tick
+        [[nodiscard]] const PlaybackStats &getPlaybackStats() const { return m_playbackStats; }
+
+        /// @brief Resets the playback counters
+        void resetPlaybackStats() { m_playbackStats = {}; }
+
     protected:
+        /// @brief Places playback of the macro or the stream on the specified frame
+        void seekPlayback(uint32_t frame);
+
         BotState m_state = BotState::Idle;
         BotFixMode m_fixMode = BotFixMode::EveryAction;
         uint32_t m_frame{};
         Macro m_macro;
+        std::shared_ptr<const Macro> m_sharedMacro; // Used instead of m_macro when set
         HandleButtonMethod m_handleButtonMethod;
         FixPlayerMethod m_fixPlayerMethod;
         RequestMacroFixMethod m_requestMacroFixMethod;
         GetFrameMethod m_getFrameMethod;
+        Macro::PlaybackCursor m_cursor{m_macro};
+        std::unique_ptr<MacroStream> m_stream; // Used instead of the macro when set
+        MacroStream::Step m_streamStep; // Reused by every tick
+        PlaybackStats m_playbackStats;
 
     public: // Hook callbacks
         /// @brief PlayerObject::pushButton hook
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <filesystem>
+#include <future>
+#include <memory>
+
+#include "file-io.hpp"
+
+namespace zephyrus {
+
+    /// @brief Handle to a macro file being read or written on a worker thread
+    /// @note Destroying a task that is still running cancels it and waits for the worker thread to stop.
+    class FileTask {
+    public:
+        enum class Status {
+            Running,
+            Succeeded,
+            Failed,
+            Cancelled
+        };
+
+        /// @brief Snapshot of the progress of a task, the totals are zero until they are known
+        struct Progress {
+            uint64_t bytesDone{}; // Bytes read from or written to the file
+            uint64_t bytesTotal{};
+            uint64_t recordsDone{}; // Actions and frame fixes decoded or encoded
+            uint64_t recordsTotal{};
+        };
+
+        /// @brief Shared between the handle and the worker thread
+        struct State;
+
+        FileTask() = default;
+
+        FileTask(std::shared_ptr<State> state, std::future<void> future);
+
+        ~FileTask();
+
+        FileTask(const FileTask &) = delete;
+
+        FileTask &operator=(const FileTask &) = delete;
+
+        FileTask(FileTask &&) noexcept = default;
+
+        FileTask &operator=(FileTask &&other) noexcept;
+
+        /// @brief Returns whether the handle refers to a task
+        [[nodiscard]] bool isValid() const { return m_state != nullptr; }
+
+        [[nodiscard]] Status getStatus() const;
+
+        [[nodiscard]] Progress getProgress() const;
+
+        /// @brief Returns whether the task stopped, whatever the outcome
+        [[nodiscard]] bool isDone() const { return getStatus() != Status::Running; }
+
+        /// @brief Asks the worker thread to stop, a cancelled write leaves the destination file untouched
+        /// @note A task that already finished its work when the cancel arrives still reports Succeeded
+        void cancel();
+
+        /// @brief Blocks until the task stops
+        /// @return The status the task stopped with
+        Status wait();
+
+        /// @brief Waits for the task, then hands over its macro
+        /// @note A read task holds the macro that was read (empty if the read did not succeed),
+        /// a write task holds the macro that was written. The task is left without a macro.
+        Macro takeMacro();
+
+    protected:
+        std::shared_ptr<State> m_state;
+        std::future<void> m_future;
+    };
+
+    /// @brief Reads a macro from a file on a worker thread
+    /// @param path The path to the file, in any format supported by readFromFile
+    /// @return The task, which holds the macro once it succeeds
+    FileTask readFromFileAsync(const std::filesystem::path &path);
+
+    /// @brief Writes a macro to a file on a worker thread
+    /// @note The task owns the macro until it is done (move it in to avoid a copy), takeMacro gives it back
+    /// @param macro The macro to write
+    /// @param path The path to the file
+    /// @param version The version of the native format to write (2 or 3, anything else fails), ignored for
+    /// third-party formats. Version 2 stays the default, since readers that predate version 3 cannot open it.
+    /// Pass 3 for seekable chunks, which readFromFile with a window and MacroStream can skip around in.
+    /// @param codec The compression of the chunk payloads, version 2 fails with anything but MacroFileCodec::None
+    FileTask writeToFileAsync(Macro macro, const std::filesystem::path &path, uint8_t version = 2,
+                              MacroFileCodec codec = MacroFileCodec::None);
+
+}
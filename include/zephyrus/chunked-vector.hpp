@@ -0,0 +1,293 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <type_traits>
+#include <vector>
+
+namespace zephyrus {
+
+    /// @brief An array made of fixed-size blocks listed in a block table, so growing it never copies the elements
+    /// @note Appends are O(1) in the worst case: a full array gets a new block instead of being reallocated.
+    /// Only the first block is grown by reallocation (up to BlockSize), which keeps small arrays small.
+    /// Memory comes from a std::pmr::memory_resource, with the same rules as std::pmr containers: the resource
+    /// is fixed at construction, copies use the default resource and moves keep the resource of the source.
+    template<typename T, size_t BlockSize = 4096>
+    class ChunkedVector {
+        static_assert(std::is_trivially_copyable_v<T>, "ChunkedVector only holds trivially copyable types");
+        static_assert(BlockSize > 0 && (BlockSize & (BlockSize - 1)) == 0, "BlockSize must be a power of two");
+
+    public:
+        /// @brief Random access iterator over the elements of a ChunkedVector
+        template<bool Const>
+        class Iterator {
+        public:
+            using Owner = std::conditional_t<Const, const ChunkedVector, ChunkedVector>;
+            using iterator_category = std::random_access_iterator_tag;
+            using value_type = T;
+            using difference_type = std::ptrdiff_t;
+            using pointer = std::conditional_t<Const, const T *, T *>;
+            using reference = std::conditional_t<Const, const T &, T &>;
+
+            Iterator() = default;
+
+            Iterator(Owner *owner, size_t index) : m_owner(owner), m_index(index) {}
+
+            /// @brief Allows passing a mutable iterator where a const one is expected
+            template<bool OtherConst, typename = std::enable_if_t<Const && !OtherConst>>
+            Iterator(const Iterator<OtherConst> &other) : m_owner(other.m_owner), m_index(other.m_index) {}
+
+            [[nodiscard]] reference operator*() const { return (*m_owner)[m_index]; }
+
+            [[nodiscard]] pointer operator->() const { return &(*m_owner)[m_index]; }
+
+            [[nodiscard]] reference operator[](difference_type offset) const { return (*m_owner)[m_index + offset]; }
+
+            /// @brief Returns the position of the iterator in the array
+            [[nodiscard]] size_t getIndex() const { return m_index; }
+
+            Iterator &operator++() { ++m_index; return *this; }
+
+            Iterator operator++(int) { Iterator copy = *this; ++m_index; return copy; }
+
+            Iterator &operator--() { --m_index; return *this; }
+
+            Iterator operator--(int) { Iterator copy = *this; --m_index; return copy; }
+
+            Iterator &operator+=(difference_type offset) { m_index += offset; return *this; }
+
+            Iterator &operator-=(difference_type offset) { m_index -= offset; return *this; }
+
+            [[nodiscard]] Iterator operator+(difference_type offset) const { return {m_owner, m_index + offset}; }
+
+            [[nodiscard]] Iterator operator-(difference_type offset) const { return {m_owner, m_index - offset}; }
+
+            [[nodiscard]] difference_type operator-(const Iterator &other) const {
+                return static_cast<difference_type>(m_index) - static_cast<difference_type>(other.m_index);
+            }
+
+            [[nodiscard]] bool operator==(const Iterator &other) const { return m_index == other.m_index; }
+
+            [[nodiscard]] bool operator!=(const Iterator &other) const { return m_index != other.m_index; }
+
+            [[nodiscard]] bool operator<(const Iterator &other) const { return m_index < other.m_index; }
+
+            [[nodiscard]] bool operator>(const Iterator &other) const { return m_index > other.m_index; }
+
+            [[nodiscard]] bool operator<=(const Iterator &other) const { return m_index <= other.m_index; }
+
+            [[nodiscard]] bool operator>=(const Iterator &other) const { return m_index >= other.m_index; }
+
+        protected:
+            template<bool> friend class Iterator;
+
+            Owner *m_owner = nullptr;
+            size_t m_index{};
+        };
+
+        using value_type = T;
+        using iterator = Iterator<false>;
+        using const_iterator = Iterator<true>;
+
+        static constexpr size_t BlockShift = [] {
+            size_t shift = 0;
+            while ((size_t(1) << shift) < BlockSize) shift++;
+            return shift;
+        }();
+
+        ChunkedVector() = default;
+
+        explicit ChunkedVector(std::pmr::memory_resource *resource) : m_resource(resource), m_blocks(resource) {}
+
+        ChunkedVector(const ChunkedVector &other) { *this = other; }
+
+        ChunkedVector(const ChunkedVector &other, std::pmr::memory_resource *resource) : ChunkedVector(resource) {
+            *this = other;
+        }
+
+        ChunkedVector(ChunkedVector &&other) noexcept : ChunkedVector(other.m_resource) { swap(other); }
+
+        ChunkedVector &operator=(const ChunkedVector &other) {
+            if (this == &other) return *this;
+            clear();
+            reserve(other.m_size);
+            for (size_t block = 0; block < other.blockCount(); block++) {
+                std::copy_n(other.m_blocks[block], other.blockLength(block), m_blocks[block]);
+            }
+            m_size = other.m_size;
+            return *this;
+        }
+
+        ChunkedVector &operator=(ChunkedVector &&other) {
+            if (m_resource->is_equal(*other.m_resource)) {
+                release(0);
+                swap(other);
+            } else {
+                // The blocks can't change owners, so they have to be copied
+                *this = other;
+            }
+            return *this;
+        }
+
+        ~ChunkedVector() { release(0); }
+
+        /// @brief Swaps the contents of two arrays that use equal memory resources
+        void swap(ChunkedVector &other) noexcept {
+            std::swap(m_blocks, other.m_blocks);
+            std::swap(m_firstBlockCapacity, other.m_firstBlockCapacity);
+            std::swap(m_capacity, other.m_capacity);
+            std::swap(m_size, other.m_size);
+        }
+
+        /// @brief Returns the memory resource that the blocks are allocated from
+        [[nodiscard]] std::pmr::memory_resource *getResource() const { return m_resource; }
+
+        [[nodiscard]] size_t size() const { return m_size; }
+
+        [[nodiscard]] bool empty() const { return m_size == 0; }
+
+        /// @brief Returns the number of elements that fit without allocating a new block
+        [[nodiscard]] size_t capacity() const { return m_capacity; }
+
+        [[nodiscard]] const T &operator[](size_t index) const { return m_blocks[index >> BlockShift][index & (BlockSize - 1)]; }
+
+        [[nodiscard]] T &operator[](size_t index) { return m_blocks[index >> BlockShift][index & (BlockSize - 1)]; }
+
+        [[nodiscard]] const T &back() const { return (*this)[m_size - 1]; }
+
+        [[nodiscard]] T &back() { return (*this)[m_size - 1]; }
+
+        [[nodiscard]] const_iterator begin() const { return {this, 0}; }
+
+        [[nodiscard]] const_iterator end() const { return {this, m_size}; }
+
+        [[nodiscard]] iterator begin() { return {this, 0}; }
+
+        [[nodiscard]] iterator end() { return {this, m_size}; }
+
+        /// @brief Returns the number of blocks that hold elements
+        [[nodiscard]] size_t blockCount() const { return (m_size + BlockSize - 1) >> BlockShift; }
+
+        /// @brief Returns the elements of a block as a contiguous array, for bulk processing
+        [[nodiscard]] const T *blockData(size_t block) const { return m_blocks[block]; }
+
+        /// @brief Returns the number of elements in a block
+        [[nodiscard]] size_t blockLength(size_t block) const {
+            return std::min(BlockSize, m_size - (block << BlockShift));
+        }
+
+        void push_back(T value) {
+            // Taken by value, growing may move the first block that the argument could point into
+            if (m_size == capacity()) grow(m_size + 1);
+            (*this)[m_size++] = value;
+        }
+
+        /// @brief Inserts an element before the specified position
+        /// @note Shifts every element after it, prefer push_back
+        void insert(const_iterator position, T value) {
+            size_t index = position.getIndex();
+            if (index == m_size) return push_back(value);
+
+            push_back(back());
+            for (size_t i = m_size - 2; i > index; i--) {
+                (*this)[i] = (*this)[i - 1];
+            }
+            (*this)[index] = value;
+        }
+
+        /// @brief Changes the number of elements, new elements are value-initialized
+        void resize(size_t count) {
+            if (count > capacity()) grow(count);
+            for (size_t i = m_size; i < count; i++) {
+                (*this)[i] = T{};
+            }
+            m_size = count;
+        }
+
+        /// @brief Changes the number of elements without initializing the new ones, which have to be written
+        /// before they are read (lets several threads fill different ranges, touching the memory themselves)
+        void resize_uninitialized(size_t count) {
+            if (count > capacity()) grow(count);
+            m_size = count;
+        }
+
+        void reserve(size_t count) {
+            if (count > capacity()) grow(count);
+        }
+
+        /// @brief Frees the blocks that hold no elements
+        void shrink_to_fit() {
+            release(blockCount());
+            if (m_blocks.size() == 1 && m_firstBlockCapacity > m_size) {
+                reallocateFirstBlock(m_size);
+            }
+            m_blocks.shrink_to_fit();
+        }
+
+        /// @brief Removes all the elements, keeping the blocks for reuse
+        void clear() { m_size = 0; }
+
+    protected:
+        /// @brief Smallest allocation for the first block
+        static constexpr size_t MinFirstBlockCapacity = BlockSize < 16 ? BlockSize : 16;
+
+        T *allocate(size_t count) { return static_cast<T *>(m_resource->allocate(count * sizeof(T), alignof(T))); }
+
+        void deallocate(T *block, size_t count) { m_resource->deallocate(block, count * sizeof(T), alignof(T)); }
+
+        /// @brief Makes room for at least the specified number of elements
+        void grow(size_t count) {
+            if (m_blocks.empty() || m_firstBlockCapacity < BlockSize) {
+                // The first block grows geometrically, so that small arrays stay small
+                size_t capacity = std::max(m_firstBlockCapacity * 2, MinFirstBlockCapacity);
+                reallocateFirstBlock(std::min(BlockSize, std::max(capacity, count)));
+            }
+            while (m_capacity < count) {
+                m_blocks.push_back(allocate(BlockSize));
+                m_capacity += BlockSize;
+            }
+        }
+
+        void reallocateFirstBlock(size_t capacity) {
+            T *block = capacity ? allocate(capacity) : nullptr;
+            if (!m_blocks.empty()) {
+                std::copy_n(m_blocks[0], std::min(m_size, capacity), block);
+                deallocate(m_blocks[0], m_firstBlockCapacity);
+                m_blocks[0] = block;
+            } else {
+                m_blocks.push_back(block);
+            }
+            m_firstBlockCapacity = capacity;
+            if (!block) m_blocks.clear();
+            updateCapacity();
+        }
+
+        /// @brief Frees every block starting from the specified one
+        void release(size_t firstBlock) {
+            for (size_t block = firstBlock; block < m_blocks.size(); block++) {
+                deallocate(m_blocks[block], block == 0 ? m_firstBlockCapacity : BlockSize);
+            }
+            if (firstBlock < m_blocks.size()) {
+                m_blocks.resize(firstBlock);
+            }
+            if (m_blocks.empty()) {
+                m_firstBlockCapacity = 0;
+            }
+            updateCapacity();
+        }
+
+        void updateCapacity() {
+            m_capacity = m_blocks.empty() ? 0 : m_firstBlockCapacity + (m_blocks.size() - 1) * BlockSize;
+        }
+
+        std::pmr::memory_resource *m_resource = std::pmr::get_default_resource();
+        std::pmr::vector<T *> m_blocks{m_resource}; // The block table
+        size_t m_firstBlockCapacity{}; // Allocated elements in the first block, all the others have BlockSize
+        size_t m_capacity{}; // Cached, push_back checks it on every call
+        size_t m_size{};
+    };
+
+}
@@ -6,6 +6,12 @@
 
 namespace zephyrus {
 
+    /// @brief Compression codecs of the chunk payloads of version 3 macro files
+    enum class MacroFileCodec : uint8_t {
+        None = 0,
+        LZ = 1 // LZ77 block compression, each payload starts with its decompressed size (u32)
+    };
+
     /// @brief The header of a macro file
     struct MacroFileHeader {
         uint16_t magic{}; // Magic number to identify the file
@@ -13,6 +19,29 @@ namespace zephyrus {
         uint32_t recordedFPS{}; // The FPS at which the macro was recorded
         uint32_t actionCount{}; // The number of actions in the macro
         uint32_t frameFixCount{}; // The number of frame fixes in the macro
+        uint32_t chunkCount{}; // The number of chunks that follow the header (version 3)
+        uint8_t codec{}; // The MacroFileCodec of the chunk payloads (version 3)
+    };
+
+    /// @brief The header of an independently decodable chunk of a version 3 macro file
+    /// @note Actions store frame deltas and packed flags, frame fixes store run-length encoded frame deltas
+    /// and their columns are XOR-encoded (Gorilla-style) floats
+    struct MacroFileChunk {
+        uint32_t firstFrame{}; // The frame of the first entry in the chunk
+        uint32_t lastFrame{}; // The frame of the last entry in the chunk
+        uint32_t actionCount{}; // The number of actions in the chunk
+        uint32_t frameFixCount{}; // The number of frame fixes in the chunk
+        uint32_t payloadSize{}; // The size of the data following the chunk header, as stored (compressed or not)
+    };
+
+    /// @brief An entry of the index at the end of a version 3 macro file, one for each chunk
+    /// @note The index is followed by its offset and a magic number, so that readers can find it from the end
+    struct MacroFileIndexEntry {
+        uint32_t firstFrame{}; // The frame of the first entry in the chunk
+        uint32_t lastFrame{}; // The frame of the last entry in the chunk
+        uint64_t offset{}; // The position of the chunk header in the file
+        uint32_t firstAction{}; // The number of actions in the previous chunks
+        uint32_t firstFrameFix{}; // The number of frame fixes in the previous chunks
     };
 
     /// @brief Contains information about a player action in a frame
@@ -39,9 +68,24 @@ namespace zephyrus {
     /// @return True if the macro was read successfully, false otherwise
     bool readFromFile(const std::filesystem::path &path, Macro &macro);
 
+    /// @brief Reads the actions and frame fixes of a frame window from a file
+    /// @note Version 3 files only decode the chunks that overlap the window, other formats are read whole
+    /// @param path The path to the file
+    /// @param macro The macro to read into
+    /// @param startFrame The first frame to read
+    /// @param endFrame The last frame to read (inclusive)
+    /// @return True if the window was read successfully, false otherwise
+    bool readFromFile(const std::filesystem::path &path, Macro &macro, uint32_t startFrame, uint32_t endFrame);
+
     /// @brief Writes a macro to a file
     /// @param macro The macro to write
     /// @param path The path to the file
-    void writeToFile(const Macro &macro, const std::filesystem::path &path);
+    /// @param version The version of the native format to write (2 or 3, anything else fails), ignored for
+    /// third-party formats. Version 2 stays the default, since readers that predate version 3 cannot open it.
+    /// Pass 3 for seekable chunks, which readFromFile with a window and MacroStream can skip around in.
+    /// @param codec The compression of the chunk payloads, version 2 fails with anything but MacroFileCodec::None
+    /// @return True if the file was written, false otherwise (the previous file is left untouched)
+    bool writeToFile(const Macro &macro, const std::filesystem::path &path, uint8_t version = 2,
+                     MacroFileCodec codec = MacroFileCodec::None);
 
 }
\ No newline at end of file
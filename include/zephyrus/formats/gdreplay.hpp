@@ -1,14 +1,38 @@
+#pragma once
+
 #include "../macro.hpp"
 
 #include <filesystem>
 
 namespace zephyrus::formats::GDR {
 
+    /// @brief The encodings a GDReplay file can be written in
+    enum class Encoding {
+        JSON, // Pretty-printed with 4 spaces of indentation
+        CompactJSON,
+        MessagePack
+    };
+
+    /// @brief Options for writing GDReplay files
+    struct WriteOptions {
+        Encoding encoding = Encoding::MessagePack;
+    };
+
+    /// @brief Returns whether a path has a GDReplay extension (.gdr, or .gdr.json for JSON replays)
+    bool isReplayPath(const std::filesystem::path &path);
+
     /// @brief Convert a GDReplay macro file to a Zephyrus macro
     /// @note https://github.com/maxnut/GDReplayFormat
     bool readFromFile(const std::filesystem::path &path, Macro &macro);
 
     /// @brief Convert a Zephyrus macro to a GDReplay macro file
-    void writeToFile(const Macro &macro, const std::filesystem::path &path);
+    /// @note The encoding follows the extension: MessagePack for .gdr, compact JSON for .gdr.json
+    /// @return True if the file was written successfully, false otherwise
+    bool writeToFile(const Macro &macro, const std::filesystem::path &path);
+
+    /// @brief Convert a Zephyrus macro to a GDReplay macro file with the specified options
+    /// @note The replay goes through a temporary file that is renamed over the destination once it is complete
+    /// @return True if the file was written successfully, false otherwise (the previous file is left untouched)
+    bool writeToFile(const Macro &macro, const std::filesystem::path &path, const WriteOptions &options);
 
-}
\ No newline at end of file
+}
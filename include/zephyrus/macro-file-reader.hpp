@@ -0,0 +1,102 @@
+#pragma once
+
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+#include "file-io.hpp"
+
+namespace zephyrus {
+
+    /// @brief Reads the actions and frame fixes of a native macro file (.zr) in batches, straight from disk
+    /// @note Only one batch is kept in memory at a time, so any file size can be processed with bounded memory.
+    /// Version 3 batches are chunks, which hold the actions and frame fixes of the same frame range.
+    /// Version 2 files store every action before the frame fixes, so their batches hold up to BatchSize actions
+    /// until all of them are read, then up to BatchSize frame fixes.
+    class MacroFileReader {
+    public:
+        /// @brief Maximum number of records in a batch of a version 2 file
+        static constexpr size_t BatchSize = 4096;
+
+        /// @brief Entries read at once, both arrays are sorted by frame
+        struct Batch {
+            std::vector<Macro::Frame> actions;
+            std::vector<Macro::FrameFix> frameFixes;
+
+            [[nodiscard]] bool empty() const { return actions.empty() && frameFixes.empty(); }
+
+            void clear() {
+                actions.clear();
+                frameFixes.clear();
+            }
+        };
+
+        MacroFileReader() = default;
+
+        MacroFileReader(MacroFileReader &&) = default;
+
+        MacroFileReader &operator=(MacroFileReader &&) = default;
+
+        /// @brief Opens a macro file and reads its header
+        /// @return True if the file is a version 2 or 3 Zephyrus macro, false otherwise
+        bool open(const std::filesystem::path &path);
+
+        void close();
+
+        [[nodiscard]] bool isOpen() const { return m_file.is_open(); }
+
+        [[nodiscard]] const MacroFileHeader &getHeader() const { return m_header; }
+
+        /// @brief Reads the next batch, replacing the contents of the batch
+        /// @return False once every entry was read, or if the file is corrupted (see hasFailed)
+        bool readBatch(Batch &batch);
+
+        /// @brief Moves the reader to the first batch that holds entries on or after the specified frame
+        /// @note Version 3 files seek with their index, which is loaded on the first call. Files without an index
+        /// go back to their first batch, so that entries before the frame have to be skipped by the caller.
+        /// @return False if the reader is not open or the index is corrupted
+        bool seek(uint32_t frame);
+
+        /// @brief Returns whether reading stopped because the file is corrupted or truncated
+        [[nodiscard]] bool hasFailed() const { return m_failed; }
+
+        /// @brief Returns the number of bytes of the file consumed so far
+        [[nodiscard]] uint64_t getBytesRead() const { return m_filePosition - (m_buffer.size() - m_bufferPosition); }
+
+        [[nodiscard]] uint64_t getFileSize() const { return m_fileSize; }
+
+        /// @brief Returns the number of actions read so far
+        [[nodiscard]] size_t getActionsRead() const { return m_header.actionCount - m_actionsRemaining; }
+
+        /// @brief Returns the number of frame fixes read so far
+        [[nodiscard]] size_t getFrameFixesRead() const { return m_header.frameFixCount - m_frameFixesRemaining; }
+
+    protected:
+        /// @brief Makes sure that the buffer holds at least the specified number of unread bytes
+        bool fill(size_t count);
+
+        bool readChunk(Batch &batch);
+
+        bool readRecords(Batch &batch);
+
+        bool fail();
+
+        /// @brief Moves the reader to the specified position in the file
+        void reposition(uint64_t offset, uint32_t actionsRead, uint32_t frameFixesRead, uint32_t chunksRead);
+
+        std::ifstream m_file;
+        uint64_t m_fileSize{};
+        uint64_t m_filePosition{}; // Position of the end of the buffer in the file
+        std::vector<uint8_t> m_buffer;
+        size_t m_bufferPosition{};
+        std::vector<uint8_t> m_payload; // Decompressed payload of the last chunk, for compressed files
+        MacroFileHeader m_header{};
+        uint32_t m_actionsRemaining{};
+        uint32_t m_frameFixesRemaining{};
+        uint32_t m_chunksRemaining{};
+        bool m_failed = false;
+        std::vector<MacroFileIndexEntry> m_index; // Loaded by the first seek
+        bool m_hasIndex = false;
+    };
+
+}
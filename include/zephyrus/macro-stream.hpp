@@ -0,0 +1,142 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "macro-file-reader.hpp"
+
+namespace zephyrus {
+
+    /// @brief Plays a macro file straight from disk, without loading it into a Macro
+    /// @note A background thread decodes the batches ahead of the playback frame into a fixed ring of slots,
+    /// so memory use does not depend on the length of the macro. The playback side (advance and seek) never waits
+    /// for that thread or for the disk: if the batch it needs is not decoded yet, it returns what it has and counts
+    /// an underrun, and the missing entries are returned by a later advance. A few batches behind the playback frame
+    /// stay in the ring, so that short respawns do not have to go back to the disk. Only version 3 files can be
+    /// streamed, since version 2 files store every action before the frame fixes.
+    /// writeToFile writes version 2 unless asked for version 3.
+    class MacroStream {
+    public:
+        /// @brief Default number of batches in the ring, a quarter of which are kept behind the playback frame
+        static constexpr size_t DefaultCapacity = 8;
+
+        /// @brief Actions and frame fixes passed by a single advance (kept by the caller to reuse the memory)
+        struct Step {
+            std::vector<Macro::Frame> frames; // Actions in (last frame, new frame]
+            std::vector<Macro::FrameFix> frameFixes; // Frame fixes in (last frame, new frame]
+
+            /// @brief Makes room for a whole batch, so that advance never allocates (it reserves on first use otherwise)
+            void reserve() {
+                frames.reserve(MacroFileReader::BatchSize);
+                frameFixes.reserve(MacroFileReader::BatchSize);
+            }
+        };
+
+        explicit MacroStream(size_t capacity = DefaultCapacity);
+
+        ~MacroStream() { close(); }
+
+        MacroStream(const MacroStream &) = delete;
+
+        MacroStream &operator=(const MacroStream &) = delete;
+
+        /// @brief Opens a macro file and starts decoding it in the background
+        /// @return True if the file is a version 3 Zephyrus macro, false otherwise
+        bool open(const std::filesystem::path &path);
+
+        /// @brief Stops the background thread and closes the file
+        void close();
+
+        [[nodiscard]] bool isOpen() const { return m_thread.joinable(); }
+
+        [[nodiscard]] const MacroFileHeader &getHeader() const { return m_header; }
+
+        /// @brief Moves playback to the specified frame and returns everything that was passed on the way
+        /// @note Works like Macro::PlaybackCursor::advance. Never blocks and never grows the step: entries that do
+        /// not fit in the step (a batch of each) are left for the next advance, which counts as an underrun.
+        /// @return False if an underrun happened, in which case the step might be missing entries
+        bool advance(uint32_t frame, Step &step);
+
+        /// @brief Places playback on the specified frame
+        /// @note Works like Macro::PlaybackCursor::seek. Seeking within the batches in the ring is immediate,
+        /// other seeks are handed to the background thread, which finds the batch with the file index. Advances
+        /// underrun until that batch is decoded.
+        void seek(uint32_t frame);
+
+        /// @brief Returns the frame playback is on
+        [[nodiscard]] uint32_t getFrame() const { return m_frame; }
+
+        /// @brief Returns the number of advances that needed a batch the background thread had not decoded yet
+        [[nodiscard]] uint64_t getUnderrunCount() const { return m_underrunCount; }
+
+        /// @brief Returns whether the background thread stopped because the file is corrupted
+        [[nodiscard]] bool hasFailed() const { return m_failed.load(std::memory_order_acquire); }
+
+    protected:
+        /// @brief A decoded batch in the ring
+        struct Slot {
+            MacroFileReader::Batch batch;
+            uint32_t generation{}; // Seek generation the batch was decoded for
+            uint32_t firstFrame{}; // Frame of the first entry in the batch
+            uint32_t lastFrame{}; // Frame of the last entry in the batch
+            bool first{}; // Whether the batch starts the file, so that no entry comes before it
+        };
+
+        /// @brief Returns the number of played batches that are kept in the ring for seeking back
+        [[nodiscard]] size_t getRetainedCount() const { return m_slots.size() / 4; }
+
+        /// @brief Moves the head to the batch in the ring that holds the entries on or after the frame
+        /// @return False if the file has to be read again from the frame
+        bool seekRetained(uint32_t frame, bool backwards);
+
+        /// @brief Body of the background thread
+        void run();
+
+        /// @brief Returns whether the background thread has a batch to decode
+        [[nodiscard]] bool hasWork() const;
+
+        /// @brief Decodes the next batch into the slot at the tail of the ring (the ring must not be full)
+        /// @return False once every batch was decoded, or if the file is corrupted
+        bool decodeSlot(uint32_t generation);
+
+        /// @brief Frees the slot at the head of the ring for the background thread
+        void popSlot();
+
+        /// @brief Wakes up the background thread after the state it waits on changed
+        void wakeUp();
+
+        MacroFileReader m_reader; // Only used by the background thread once it is started
+        MacroFileHeader m_header{};
+        std::vector<Slot> m_slots;
+        std::thread m_thread;
+        std::mutex m_mutex; // Held by wakeups, so that the background thread cannot miss one
+        std::condition_variable m_wakeup;
+
+        // Shared between the two threads
+        std::atomic<size_t> m_oldest{}; // Oldest slot kept for seeking back, only written by the playback side
+        std::atomic<size_t> m_head{}; // Next slot to play, only written by the playback side
+        std::atomic<size_t> m_tail{}; // Next slot to decode, only written by the background thread
+        std::atomic<uint32_t> m_requestedGeneration{}; // Incremented by seeks that need the background thread
+        std::atomic<uint32_t> m_requestedFrame{};
+        std::atomic<uint32_t> m_finishedGeneration{UINT32_MAX}; // Generation for which every batch was decoded
+        std::atomic<bool> m_failed{false};
+        std::atomic<bool> m_stopping{false};
+
+        // Only used by the background thread
+        uint32_t m_readerGeneration{}; // Generation the reader is positioned for
+
+        // Only used by the playback side
+        uint32_t m_generation{};
+        uint32_t m_frame{};
+        uint32_t m_actionFloor{}; // Actions on or before this frame were already played
+        uint32_t m_frameFixFloor{}; // Frame fixes before this frame were already played
+        size_t m_actionIndex{}; // Position in the batch at the head of the ring
+        size_t m_frameFixIndex{};
+        uint64_t m_underrunCount{};
+    };
+
+}
@@ -2,7 +2,12 @@
 
 #include <string>
 #include <vector>
+#include <cstddef>
 #include <cstdint>
+#include <iterator>
+#include <memory_resource>
+
+#include "chunked-vector.hpp"
 
 namespace zephyrus {
 
@@ -12,30 +17,83 @@ namespace zephyrus {
         Right = 3
     };
 
+    /// @brief A pair of iterators that can be used in range-based for loops
+    template<typename Iterator>
+    class IteratorRange {
+    public:
+        using value_type = typename std::iterator_traits<Iterator>::value_type;
+
+        IteratorRange() = default;
+
+        IteratorRange(Iterator begin, Iterator end) : m_begin(begin), m_end(end) {}
+
+        [[nodiscard]] Iterator begin() const { return m_begin; }
+
+        [[nodiscard]] Iterator end() const { return m_end; }
+
+        [[nodiscard]] size_t size() const { return static_cast<size_t>(m_end - m_begin); }
+
+        [[nodiscard]] bool empty() const { return m_begin == m_end; }
+
+        [[nodiscard]] decltype(auto) operator[](size_t index) const { return m_begin[index]; }
+
+        [[nodiscard]] decltype(auto) front() const { return *m_begin; }
+
+        [[nodiscard]] decltype(auto) back() const { return *(m_end - 1); }
+
+        /// @brief Copies the entries of the range into a vector
+        [[nodiscard]] std::vector<value_type> toVector() const {
+            std::vector<value_type> entries;
+            entries.reserve(size());
+            entries.assign(m_begin, m_end);
+            return entries;
+        }
+
+        /// @brief Copies the entries of the range, for code written against accessors that returned a std::vector
+        operator std::vector<value_type>() const { return toVector(); }
+
+    protected:
+        Iterator m_begin{};
+        Iterator m_end{};
+    };
+
     /// @brief A class that defines a macro and contains information about all the frames
+    /// @note Frames and frame fixes are always kept sorted by frame number (entries on the same frame keep
+    /// the order in which they were added). Range queries and the playback cursor rely on this.
     class Macro {
     public:
 
         /// @brief A class that defines one frame of a macro and contains information about player input
+        /// @note Packed into 5 bytes, using the same flags layout as MacroFileAction
+#pragma pack(push, 1)
         class Frame {
         public:
             Frame(uint32_t frame, bool secondPlayer, PlayerButton button, bool pressed) :
-                    m_frame(frame), m_secondPlayer(secondPlayer), m_button(button), m_pressed(pressed) {}
+                    m_frame(frame),
+                    m_flags(static_cast<uint8_t>((secondPlayer ? 0b10000000 : 0) |
+                                                 (pressed ? 0b01000000 : 0) |
+                                                 ((static_cast<uint8_t>(button) & 0b11) << 4))) {}
+
+            Frame(uint32_t frame, uint8_t flags) : m_frame(frame), m_flags(flags) {}
 
             [[nodiscard]] uint32_t getFrame() const { return m_frame; }
 
-            [[nodiscard]] bool isSecondPlayer() const { return m_secondPlayer; }
+            [[nodiscard]] bool isSecondPlayer() const { return m_flags & 0b10000000; }
+
+            [[nodiscard]] PlayerButton getButton() const { return static_cast<PlayerButton>((m_flags & 0b00110000) >> 4); }
 
-            [[nodiscard]] PlayerButton getButton() const { return m_button; }
+            [[nodiscard]] bool isPressed() const { return m_flags & 0b01000000; }
 
-            [[nodiscard]] bool isPressed() const { return m_pressed; }
+            /// @brief Returns the packed flags: 1 bit (isPlayer2) | 1 bit (isButtonDown) | 2 bits (button)
+            [[nodiscard]] uint8_t getFlags() const { return m_flags; }
 
         protected:
             uint32_t m_frame;
-            bool m_secondPlayer;
-            PlayerButton m_button;
-            bool m_pressed;
+            uint8_t m_flags;
         };
+#pragma pack(pop)
+
+        static_assert(sizeof(Frame) == 5, "Macro::Frame must stay packed");
 
         /// @brief A class that defines a frame fix and contains information about the state of the game to fix desyncs
         class FrameFix {
@@ -69,9 +127,369 @@ namespace zephyrus {
             PlayerData m_player2{};
         };
 
+        /// @brief Column-oriented storage for frame fixes, with one array per field
+        /// @note Player 2 data is kept in separate columns and only stored for the fixes that have it.
+        /// While fixes are appended on (nearly) every frame, the storage stays in dense mode: the frame column is
+        /// replaced by a base frame and a presence bitmap over (frame - base frame), and frame lookups are O(1).
+        /// Anything else (duplicate frames, out of order inserts, large gaps) switches it to sparse mode.
+        class FrameFixStorage {
+        public:
+            /// @brief Dense mode is kept while the bitmap has at most this many bits per stored fix
+            static constexpr size_t MaxSlotsPerDenseFix = 8;
+
+            /// @brief Fix columns are chunked, so that recording never copies them to grow
+            template<typename T>
+            using Column = ChunkedVector<T>;
+
+            /// @brief Player data split into one column per field
+            struct PlayerColumns {
+                Column<float> x;
+                Column<float> y;
+                Column<double> ySpeed;
+                Column<float> rotation;
+
+                PlayerColumns() = default;
+
+                explicit PlayerColumns(std::pmr::memory_resource *resource) :
+                        x(resource), y(resource), ySpeed(resource), rotation(resource) {}
+
+                PlayerColumns(const PlayerColumns &other, std::pmr::memory_resource *resource) :
+                        x(other.x, resource), y(other.y, resource), ySpeed(other.ySpeed, resource),
+                        rotation(other.rotation, resource) {}
+
+                PlayerColumns(const PlayerColumns &) = default;
+
+                PlayerColumns(PlayerColumns &&) = default;
+
+                PlayerColumns &operator=(const PlayerColumns &) = default;
+
+                PlayerColumns &operator=(PlayerColumns &&) = default;
+
+                [[nodiscard]] size_t size() const { return x.size(); }
+
+                [[nodiscard]] FrameFix::PlayerData get(size_t index) const {
+                    return {x[index], y[index], ySpeed[index], rotation[index]};
+                }
+
+                void insert(size_t index, const FrameFix::PlayerData &data);
+
+                void push_back(const FrameFix::PlayerData &data) {
+                    x.push_back(data.x);
+                    y.push_back(data.y);
+                    ySpeed.push_back(data.ySpeed);
+                    rotation.push_back(data.rotation);
+                }
+
+                void resize(size_t count);
+
+                void reserve(size_t count);
+
+                void shrinkToFit();
+
+                void clear();
+            };
+
+            /// @brief Iterator that assembles frame fixes from the columns
+            /// @note It has the operations of a random access iterator, but dereferencing returns a value, so it is
+            /// only an input iterator for the standard library. Search with lowerBound and upperBound instead.
+            /// The iterator carries the bitmap slot and the player 2 position of its fix, so dereferencing and
+            /// incrementing are O(1). Jumping to an index (constructor, +, -, --) looks them up in O(log n).
+            class Iterator {
+            public:
+                using iterator_category = std::input_iterator_tag;
+                using value_type = FrameFix;
+                using difference_type = std::ptrdiff_t;
+                using pointer = void;
+                using reference = const FrameFix; // A const value so that `auto &` loops keep compiling
+
+                Iterator() = default;
+
+                Iterator(const FrameFixStorage *storage, size_t index);
+
+                [[nodiscard]] reference operator*() const;
+
+                [[nodiscard]] reference operator[](difference_type offset) const { return *(*this + offset); }
+
+                /// @brief Returns the position of the iterator in the storage
+                [[nodiscard]] size_t getIndex() const { return m_index; }
+
+                Iterator &operator++();
+
+                Iterator operator++(int) { Iterator copy = *this; ++*this; return copy; }
+
+                Iterator &operator--() { return *this = {m_storage, m_index - 1}; }
+
+                Iterator operator--(int) { Iterator copy = *this; --*this; return copy; }
+
+                Iterator &operator+=(difference_type offset) { return *this = {m_storage, m_index + offset}; }
+
+                Iterator &operator-=(difference_type offset) { return *this = {m_storage, m_index - offset}; }
+
+                [[nodiscard]] Iterator operator+(difference_type offset) const { return {m_storage, m_index + offset}; }
+
+                [[nodiscard]] Iterator operator-(difference_type offset) const { return {m_storage, m_index - offset}; }
+
+                [[nodiscard]] difference_type operator-(const Iterator &other) const {
+                    return static_cast<difference_type>(m_index) - static_cast<difference_type>(other.m_index);
+                }
+
+                [[nodiscard]] bool operator==(const Iterator &other) const { return m_index == other.m_index; }
+
+                [[nodiscard]] bool operator!=(const Iterator &other) const { return m_index != other.m_index; }
+
+                [[nodiscard]] bool operator<(const Iterator &other) const { return m_index < other.m_index; }
+
+                [[nodiscard]] bool operator>(const Iterator &other) const { return m_index > other.m_index; }
+
+                [[nodiscard]] bool operator<=(const Iterator &other) const { return m_index <= other.m_index; }
+
+                [[nodiscard]] bool operator>=(const Iterator &other) const { return m_index >= other.m_index; }
+
+            protected:
+                friend class FrameFixStorage;
+
+                /// @brief Marks a slot that is looked up when needed, for iterators past the last fix
+                static constexpr size_t UnknownSlot = SIZE_MAX;
+
+                Iterator(const FrameFixStorage *storage, size_t index, size_t slot, size_t player2) :
+                        m_storage(storage), m_index(index), m_slot(slot), m_player2(player2) {}
+
+                const FrameFixStorage *m_storage = nullptr;
+                size_t m_index{};
+                size_t m_slot = UnknownSlot; // Bitmap slot of the fix (dense mode only)
+                size_t m_player2{}; // Number of fixes with player 2 data before this one
+            };
+
+            FrameFixStorage() = default;
+
+            explicit FrameFixStorage(std::pmr::memory_resource *resource);
+
+            FrameFixStorage(const FrameFixStorage &other, std::pmr::memory_resource *resource);
+
+            FrameFixStorage(const FrameFixStorage &) = default;
+
+            FrameFixStorage(FrameFixStorage &&) = default;
+
+            FrameFixStorage &operator=(const FrameFixStorage &) = default;
+
+            FrameFixStorage &operator=(FrameFixStorage &&) = default;
+
+            [[nodiscard]] size_t size() const { return m_player1.size(); }
+
+            [[nodiscard]] bool empty() const { return m_player1.size() == 0; }
+
+            [[nodiscard]] Iterator begin() const { return {this, 0, m_dense && !empty() ? 0 : Iterator::UnknownSlot, 0}; }
+
+            [[nodiscard]] Iterator end() const { return {this, size(), Iterator::UnknownSlot, m_player2Index.size()}; }
+
+            [[nodiscard]] const FrameFix operator[](size_t index) const;
+
+            [[nodiscard]] const FrameFix front() const { return (*this)[0]; }
+
+            [[nodiscard]] const FrameFix back() const { return (*this)[size() - 1]; }
+
+            /// @brief Assembles every fix into a vector
+            [[nodiscard]] std::vector<FrameFix> toVector() const;
+
+            /// @brief Assembles every fix, for code written against getFrameFixes when it returned a std::vector
+            operator std::vector<FrameFix>() const { return toVector(); }
+
+            /// @brief Returns the frame of a fix without assembling the whole fix
+            [[nodiscard]] uint32_t getFrame(size_t index) const {
+                if (!m_dense) return m_frame[index];
+                if (m_slotCount == size()) return m_baseFrame + static_cast<uint32_t>(index); // No gaps
+                return m_baseFrame + static_cast<uint32_t>(selectSlot(index));
+            }
+
+            /// @brief Returns the index of the first fix with a frame not less than the specified frame
+            [[nodiscard]] size_t lowerBound(uint32_t frame) const;
+
+            /// @brief Returns the index of the first fix with a frame greater than the specified frame
+            [[nodiscard]] size_t upperBound(uint32_t frame) const;
+
+            /// @brief Returns an iterator to the first fix with a frame greater than the specified frame
+            /// @param from An iterator on a fix on or before the frame, where the search starts
+            /// @note O(1) in dense mode, linear in the number of fixes passed in sparse mode
+            [[nodiscard]] Iterator upperBound(Iterator from, uint32_t frame) const;
+
+            /// @brief Inserts a fix at the specified index
+            /// @param player2 The data for player 2, or nullptr if player 2 does not exist
+            void insert(size_t index, uint32_t frame, const FrameFix::PlayerData &player1, const FrameFix::PlayerData *player2);
+
+            /// @brief Inserts a fix after every fix on the same or earlier frames, appending is O(1)
+            /// @param player2 The data for player 2, or nullptr if player 2 does not exist
+            void insertSorted(uint32_t frame, const FrameFix::PlayerData &player1, const FrameFix::PlayerData *player2);
+
+            /// @brief Removes all the fixes starting from the specified index
+            void truncate(size_t count);
+
+            /// @brief Clears the storage and makes room for fixes that are set by index (see Macro::resizeForLoad)
+            void resizeForLoad(size_t count);
+
+            /// @brief Sets the frame and the player 1 data of a fix, fixes at different indices can be set concurrently
+            void set(size_t index, uint32_t frame, const FrameFix::PlayerData &player1) {
+                m_frame[index] = frame;
+                m_player1.x[index] = player1.x;
+                m_player1.y[index] = player1.y;
+                m_player1.ySpeed[index] = player1.ySpeed;
+                m_player1.rotation[index] = player1.rotation;
+            }
+
+            /// @brief Adds player 2 data to a fix, in increasing index order
+            void setPlayer2(size_t index, const FrameFix::PlayerData &player2) {
+                m_player2Index.push_back(static_cast<uint32_t>(index));
+                m_player2.push_back(player2);
+            }
+
+            /// @brief Moves the frames of the fixes to the bitmap if appending them would have kept dense mode
+            void finishLoad();
+
+            void reserve(size_t count);
+
+            /// @brief Returns the number of fixes that fit without reallocating
+            [[nodiscard]] size_t capacity() const { return m_player1.x.capacity(); }
+
+            /// @brief Gives the unused capacity back to the allocator
+            void shrinkToFit();
+
+            void clear();
+
+            /// @brief Returns whether the fixes are stored in dense mode
+            [[nodiscard]] bool isDense() const { return m_dense; }
+
+            /// @brief Returns the frame of the first bit in the presence bitmap (dense mode only)
+            [[nodiscard]] uint32_t getBaseFrame() const { return m_baseFrame; }
+
+            /// @brief Returns the presence bitmap, bit N is set if there is a fix on the base frame + N (dense mode only)
+            [[nodiscard]] const Column<uint64_t> &getPresenceBitmap() const { return m_presence; }
+
+            /// @brief Returns the frame column (sparse mode only)
+            [[nodiscard]] const Column<uint32_t> &getFrameColumn() const { return m_frame; }
+
+            /// @brief Returns the player 1 columns, which have an entry for every fix
+            [[nodiscard]] const PlayerColumns &getPlayer1Columns() const { return m_player1; }
+
+            /// @brief Returns the player 2 columns, which only have entries for the fixes listed in getPlayer2Indices
+            [[nodiscard]] const PlayerColumns &getPlayer2Columns() const { return m_player2; }
+
+            /// @brief Returns the sorted indices of the fixes that have player 2 data
+            [[nodiscard]] const Column<uint32_t> &getPlayer2Indices() const { return m_player2Index; }
+
+        protected:
+            /// @brief Returns the number of fixes before the specified bitmap slot (dense mode only)
+            [[nodiscard]] size_t rankSlot(size_t slot) const;
+
+            /// @brief Returns the bitmap slot of the fix at the specified index (dense mode only)
+            [[nodiscard]] size_t selectSlot(size_t index) const;
+
+            /// @brief Returns the first bitmap slot with a fix, starting from the specified slot (dense mode only)
+            [[nodiscard]] size_t nextSlot(size_t slot) const;
+
+            /// @brief Tries to record a fix on the specified frame in the bitmap, returns false if that would make it too sparse
+            bool appendDense(uint32_t frame);
+
+            /// @brief Moves the frames from the bitmap to the frame column
+            void convertToSparse();
+
+            bool m_dense = true;
+            uint32_t m_baseFrame{};
+            size_t m_slotCount{}; // Number of bits used in the bitmap
+            Column<uint64_t> m_presence; // Chunked like the other columns, so that growing it never copies it
+            Column<uint32_t> m_presenceRank; // Number of fixes before each bitmap word
+            Column<uint32_t> m_frame;
+            PlayerColumns m_player1;
+            Column<uint32_t> m_player2Index;
+            PlayerColumns m_player2;
+        };
+
+        using FrameRange = IteratorRange<std::pmr::vector<Frame>::const_iterator>;
+        using FrameFixRange = IteratorRange<FrameFixStorage::Iterator>;
+
+        /// @brief Remembers the playback position in a macro, so that moving forward does not search again
+        /// @note The cursor keeps a pointer to the macro, which has to outlive it
+        class PlaybackCursor {
+        public:
+            /// @brief Actions and frame fixes passed by a single advance
+            struct Step {
+                FrameRange frames; // Actions in (last frame, new frame]
+                FrameFixRange frameFixes; // Frame fixes in (last frame, new frame]
+            };
+
+            explicit PlaybackCursor(const Macro &macro, uint32_t frame = 0) : m_macro(&macro) { seek(frame); }
+
+            /// @brief Moves the cursor to the specified frame and returns everything that was passed on the way
+            /// @note Moving backwards seeks instead, and only returns the frame fixes on the specified frame
+            Step advance(uint32_t frame);
+
+            /// @brief Places the cursor on the specified frame using a binary search
+            /// @note Actions on this frame are treated as already played, frame fixes are returned by the next advance
+            void seek(uint32_t frame);
+
+            /// @brief Returns the frame the cursor is on
+            [[nodiscard]] uint32_t getFrame() const { return m_frame; }
+
+        protected:
+            const Macro *m_macro;
+            uint32_t m_frame{};
+            size_t m_frameIndex{}; // Index of the first action after the current frame
+            FrameFixStorage::Iterator m_frameFix; // First frame fix that has not been returned yet
+        };
+
+        Macro() = default;
+
+        /// @brief Creates an empty macro that allocates its frames and frame fixes from the specified memory resource
+        /// @note Like std::pmr containers, copies use the default resource unless one is passed in
+        explicit Macro(std::pmr::memory_resource *resource) : m_frames(resource), m_frameFixes(resource) {}
+
+        /// @brief Copies a macro into the specified memory resource
+        Macro(const Macro &other, std::pmr::memory_resource *resource) :
+                m_frames(other.m_frames, resource), m_frameFixes(other.m_frameFixes, resource) {}
+
+        Macro(const Macro &) = default;
+
+        Macro(Macro &&) = default;
+
+        Macro &operator=(const Macro &) = default;
+
+        Macro &operator=(Macro &&) = default;
+
+        /// @brief Returns the memory resource that the macro allocates from
+        [[nodiscard]] std::pmr::memory_resource *getResource() const { return m_frames.get_allocator().resource(); }
+
         /// @brief Adds a frame to the macro
+        /// @note Appending in frame order is O(1), older frames are inserted at their sorted position
         void addFrame(uint32_t frame, bool secondPlayer, PlayerButton button, bool pressed);
 
+        /// @brief Adds a frame to the macro using packed flags (see Frame::getFlags)
+        void addFrame(uint32_t frame, uint8_t flags);
+
+        /// @brief Preallocates room for the specified number of frames and frame fixes
+        void reserve(size_t frames, size_t frameFixes) {
+            m_frames.reserve(frames);
+            m_frameFixes.reserve(frameFixes);
+        }
+
+        /// @brief Replaces the entries of the macro with placeholders that a file reader sets by index
+        /// @note setFrame and setFrameFix can be called concurrently for different indices, the entries have to end
+        /// up sorted by frame, and finishLoad has to be called once every entry is set
+        void resizeForLoad(size_t frames, size_t frameFixes);
+
+        /// @brief Sets an action of a macro that is being loaded (see resizeForLoad)
+        void setFrame(size_t index, uint32_t frame, uint8_t flags) { m_frames[index] = Frame(frame, flags); }
+
+        /// @brief Sets a frame fix of a macro that is being loaded, without its player 2 data (see resizeForLoad)
+        void setFrameFix(size_t index, uint32_t frame, const FrameFix::PlayerData &player1) {
+            m_frameFixes.set(index, frame, player1);
+        }
+
+        /// @brief Adds player 2 data to a frame fix of a macro that is being loaded, in increasing index order
+        void setFrameFixPlayer2(size_t index, const FrameFix::PlayerData &player2) {
+            m_frameFixes.setPlayer2(index, player2);
+        }
+
+        /// @brief Finishes loading a macro, leaving it as if every entry had been added in order
+        void finishLoad() { m_frameFixes.finishLoad(); }
+
         /// @brief Clears all the frames in the macro
         inline void clearFrames() {
             m_frames.clear();
@@ -79,16 +497,28 @@ namespace zephyrus {
         }
 
         /// @brief Clears all the frames in the macro from the specified frame
+        /// @note Takes a binary search and a resize. Memory is only given back once the remaining entries
+        /// use less than 1/ShrinkFactor of the capacity, and the capacity is at least ShrinkMinCapacity
         void clearFrames(uint32_t from);
 
+        /// @brief Truncation never shrinks containers with less capacity than this
+        static constexpr size_t ShrinkMinCapacity = 64 * 1024;
+
+        /// @brief Truncation shrinks containers that are filled less than 1/ShrinkFactor
+        static constexpr size_t ShrinkFactor = 4;
+
         /// @brief Adds a frame fix to the macro with the data for player 1
+        /// @note Appending in frame order is O(1), older frames are inserted at their sorted position
         void addFrameFix(uint32_t frame, FrameFix::PlayerData player1);
 
         /// @brief Adds a frame fix to the macro with the data for both players
         void addFrameFix(uint32_t frame, FrameFix::PlayerData player1, FrameFix::PlayerData player2);
 
-        /// @brief Returns all the frames in the macro
-        [[nodiscard]] const std::vector<Frame> &getFrames() const { return m_frames; }
+        /// @brief Returns a view of all the frames in the macro
+        /// @note The view is invalidated by any modification of the macro. This used to return the frame vector,
+        /// which is a std::pmr::vector since macros take a memory resource: code that binds the result to a
+        /// std::vector still compiles, but copies the frames (use auto instead).
+        [[nodiscard]] FrameRange getFrames() const { return {m_frames.cbegin(), m_frames.cend()}; }
 
         /// @brief Returns all the frames in the macro between the start and end frames
         [[nodiscard]] std::vector<Frame> getFrames(uint32_t startFrame, uint32_t endFrame) const;
@@ -97,7 +527,10 @@ namespace zephyrus {
         [[nodiscard]] std::vector<Frame> getFrames(uint32_t frame) const;
 
         /// @brief Returns all the frame fixes in the macro
-        [[nodiscard]] const std::vector<FrameFix> &getFrameFixes() const { return m_frameFixes; }
+        /// @note This used to return a std::vector<FrameFix>. The storage converts to one, so code that assigns the
+        /// result to a std::vector still compiles (assembling every fix), while `auto` copies the whole storage:
+        /// use `const auto &` to read the fixes in place.
+        [[nodiscard]] const FrameFixStorage &getFrameFixes() const { return m_frameFixes; }
 
         /// @brief Returns all the frame fixes in the macro between the start and end frames
         [[nodiscard]] std::vector<FrameFix> getFrameFixes(uint32_t startFrame, uint32_t endFrame) const;
@@ -105,9 +538,23 @@ namespace zephyrus {
         /// @brief Returns all the frame fixes in the macro at the specified frame
         [[nodiscard]] std::vector<FrameFix> getFrameFixes(uint32_t frame) const;
 
+        /// @brief Returns a view of the frames between the start and end frames without copying them
+        /// @note The view is invalidated by any modification of the macro
+        [[nodiscard]] FrameRange getFramesView(uint32_t startFrame, uint32_t endFrame) const;
+
+        /// @brief Returns a view of the frames at the specified frame without copying them
+        [[nodiscard]] FrameRange getFramesView(uint32_t frame) const { return getFramesView(frame, frame); }
+
+        /// @brief Returns a view of the frame fixes between the start and end frames without copying them
+        /// @note The view is invalidated by any modification of the macro
+        [[nodiscard]] FrameFixRange getFrameFixesView(uint32_t startFrame, uint32_t endFrame) const;
+
+        /// @brief Returns a view of the frame fixes at the specified frame without copying them
+        [[nodiscard]] FrameFixRange getFrameFixesView(uint32_t frame) const { return getFrameFixesView(frame, frame); }
+
     protected:
-        std::vector<Frame> m_frames;
-        std::vector<FrameFix> m_frameFixes;
+        std::pmr::vector<Frame> m_frames;
+        FrameFixStorage m_frameFixes;
     };
 
 
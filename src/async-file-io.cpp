@@ -0,0 +1,114 @@
+#include <zephyrus/async-file-io.hpp>
+
+#include "file-reader.hpp"
+
+namespace zephyrus {
+
+    struct FileTask::State {
+        FileReader::Progress progress;
+        std::atomic<Status> status{Status::Running};
+        Macro macro; // Only touched by the worker thread until the status changes
+    };
+
+    namespace {
+        /// @brief Starts a task that runs the operation on a worker thread
+        /// @param operation Returns whether the operation succeeded, given the shared state
+        template<typename Operation>
+        FileTask startTask(std::shared_ptr<FileTask::State> state, Operation operation) {
+            auto future = std::async(std::launch::async, [state, operation = std::move(operation)]() mutable {
+                bool success = false;
+                try {
+                    success = operation(*state);
+                } catch (...) {
+                    // Parsers of third-party formats throw on malformed files
+                }
+
+                // A cancel that arrives after the operation finished does not undo it, so the result decides
+                FileTask::Status status = FileTask::Status::Succeeded;
+                if (!success) {
+                    status = state->progress.cancelled.load(std::memory_order_relaxed) ?
+                             FileTask::Status::Cancelled : FileTask::Status::Failed;
+                }
+                state->status.store(status, std::memory_order_release);
+            });
+            return {std::move(state), std::move(future)};
+        }
+    }
+
+    FileTask::FileTask(std::shared_ptr<State> state, std::future<void> future) :
+            m_state(std::move(state)), m_future(std::move(future)) {}
+
+    FileTask::~FileTask() {
+        cancel();
+    }
+
+    FileTask &FileTask::operator=(FileTask &&other) noexcept {
+        if (this != &other) {
+            cancel();
+            m_state = std::move(other.m_state);
+            m_future = std::move(other.m_future);
+        }
+        return *this;
+    }
+
+    FileTask::Status FileTask::getStatus() const {
+        return m_state ? m_state->status.load(std::memory_order_acquire) : Status::Failed;
+    }
+
+    FileTask::Progress FileTask::getProgress() const {
+        if (!m_state) {
+            return {};
+        }
+
+        const auto &progress = m_state->progress;
+        Progress snapshot;
+        snapshot.bytesDone = progress.bytesDone.load(std::memory_order_relaxed);
+        snapshot.bytesTotal = progress.bytesTotal.load(std::memory_order_relaxed);
+        snapshot.recordsDone = progress.recordsDone.load(std::memory_order_relaxed);
+        snapshot.recordsTotal = progress.recordsTotal.load(std::memory_order_relaxed);
+        return snapshot;
+    }
+
+    void FileTask::cancel() {
+        if (m_state && getStatus() == Status::Running) {
+            m_state->progress.cancelled.store(true, std::memory_order_relaxed);
+        }
+    }
+
+    FileTask::Status FileTask::wait() {
+        if (m_future.valid()) {
+            m_future.wait();
+        }
+        return getStatus();
+    }
+
+    Macro FileTask::takeMacro() {
+        if (!m_state) {
+            return {};
+        }
+
+        wait();
+        return std::move(m_state->macro);
+    }
+
+    FileTask readFromFileAsync(const std::filesystem::path &path) {
+        return startTask(std::make_shared<FileTask::State>(), [path](FileTask::State &state) {
+            if (FileReader::readMacroFile(path, state.macro, &state.progress)) {
+                return true;
+            }
+
+            // Never hand over a partially read macro
+            state.macro = Macro();
+            return false;
+        });
+    }
+
+    FileTask writeToFileAsync(Macro macro, const std::filesystem::path &path, uint8_t version, MacroFileCodec codec) {
+        auto state = std::make_shared<FileTask::State>();
+        state->macro = std::move(macro);
+        return startTask(std::move(state), [path, version, codec](FileTask::State &state) {
+            return FileReader::writeMacroFile(state.macro, path, version, codec, &state.progress);
+        });
+    }
+
+}
@@ -0,0 +1,211 @@
+#include "block-codec.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace zephyrus::BlockCodec {
+
+    namespace {
+        constexpr size_t MinMatch = 4;
+        constexpr size_t MaxOffset = 65535;
+        constexpr uint32_t HashBits = 14;
+
+        // Like in LZ4, matches never start in the last 12 bytes and the last 5 bytes are always literals
+        constexpr size_t MatchStartMargin = 12;
+        constexpr size_t LastLiterals = 5;
+
+        uint32_t read32(const uint8_t *data) {
+            uint32_t value;
+            std::memcpy(&value, data, sizeof(value));
+            return value;
+        }
+
+        uint64_t read64(const uint8_t *data) {
+            uint64_t value;
+            std::memcpy(&value, data, sizeof(value));
+            return value;
+        }
+
+        uint32_t hash(uint32_t sequence) {
+            return (sequence * 2654435761u) >> (32 - HashBits);
+        }
+
+        /// @brief Returns the number of equal bytes at two positions, without reading past the limit
+        size_t countMatch(const uint8_t *a, const uint8_t *b, const uint8_t *limit) {
+            const uint8_t *start = b;
+            while (b + 8 <= limit && read64(a) == read64(b)) {
+                a += 8;
+                b += 8;
+            }
+
+            // The differing byte is found one byte at a time, which works on any endianness
+            while (b < limit && *a == *b) {
+                a++;
+                b++;
+            }
+            return b - start;
+        }
+
+        void writeLength(std::vector<uint8_t> &output, size_t length) {
+            for (; length >= 255; length -= 255) {
+                output.push_back(255);
+            }
+            output.push_back(uint8_t(length));
+        }
+
+        void writeSequence(std::vector<uint8_t> &output, const uint8_t *literals, size_t literalCount,
+                           size_t offset, size_t matchLength) {
+            size_t matchCode = matchLength - MinMatch;
+            output.push_back(uint8_t((literalCount >= 15 ? 15 : literalCount) << 4 | (matchCode >= 15 ? 15 : matchCode)));
+            if (literalCount >= 15) writeLength(output, literalCount - 15);
+            output.insert(output.end(), literals, literals + literalCount);
+            output.push_back(uint8_t(offset));
+            output.push_back(uint8_t(offset >> 8));
+            if (matchCode >= 15) writeLength(output, matchCode - 15);
+        }
+
+        void writeLastLiterals(std::vector<uint8_t> &output, const uint8_t *literals, size_t literalCount) {
+            output.push_back(uint8_t((literalCount >= 15 ? 15 : literalCount) << 4));
+            if (literalCount >= 15) writeLength(output, literalCount - 15);
+            output.insert(output.end(), literals, literals + literalCount);
+        }
+
+        /// @brief Reads the extra bytes of a length whose 4 bits were all set
+        bool readLength(const uint8_t *&input, const uint8_t *end, size_t &length) {
+            uint8_t byte;
+            do {
+                if (input == end) return false;
+                byte = *input++;
+                length += byte;
+            } while (byte == 255);
+            return true;
+        }
+    }
+
+    void compress(const uint8_t *data, size_t size, std::vector<uint8_t> &output) {
+        output.reserve(output.size() + size + size / 255 + 16);
+        if (size < MatchStartMargin + 1) {
+            writeLastLiterals(output, data, size);
+            return;
+        }
+
+        // Positions of the last sequence seen with each hash, greedy matching keeps compression fast
+        std::vector<uint32_t> table(size_t(1) << HashBits, 0);
+        const uint8_t *end = data + size;
+        const uint8_t *matchLimit = end - LastLiterals;
+        const uint8_t *startLimit = end - MatchStartMargin;
+        const uint8_t *anchor = data;
+        const uint8_t *current = data + 1;
+
+        while (current < startLimit) {
+            uint32_t sequence = read32(current);
+            uint32_t &entry = table[hash(sequence)];
+            const uint8_t *candidate = data + entry;
+            entry = uint32_t(current - data);
+
+            if (candidate >= current || size_t(current - candidate) > MaxOffset || read32(candidate) != sequence) {
+                // Skip faster through data that does not compress
+                current += 1 + ((current - anchor) >> 6);
+                continue;
+            }
+
+            // Extend the match backwards over the pending literals, then forwards
+            while (current > anchor && candidate > data && current[-1] == candidate[-1]) {
+                current--;
+                candidate--;
+            }
+            size_t matchLength = MinMatch + countMatch(candidate + MinMatch, current + MinMatch, matchLimit);
+
+            writeSequence(output, anchor, current - anchor, current - candidate, matchLength);
+            current += matchLength;
+            anchor = current;
+
+            // Remember a position inside the match, which helps with periodic data
+            if (current < startLimit) {
+                table[hash(read32(current - 2))] = uint32_t(current - 2 - data);
+            }
+        }
+
+        writeLastLiterals(output, anchor, end - anchor);
+    }
+
+    bool decompress(const uint8_t *data, size_t size, uint8_t *output, size_t outputSize) {
+        const uint8_t *input = data;
+        const uint8_t *inputEnd = data + size;
+        uint8_t *current = output;
+        uint8_t *outputEnd = output + outputSize;
+
+        // Copies go in 8 and 16 byte steps while they stay this far from the end of the buffers,
+        // the bytes written past a copy are overwritten by the next ones
+        constexpr size_t WildCopy = 32;
+
+        while (input < inputEnd) {
+            uint8_t token = *input++;
+
+            size_t literalCount = token >> 4;
+            if (literalCount == 15 && !readLength(input, inputEnd, literalCount)) return false;
+            if (literalCount > size_t(inputEnd - input) || literalCount > size_t(outputEnd - current)) return false;
+            if (literalCount <= WildCopy && size_t(inputEnd - input) >= WildCopy &&
+                size_t(outputEnd - current) >= WildCopy) {
+                std::memcpy(current, input, 16);
+                std::memcpy(current + 16, input + 16, 16);
+            } else if (literalCount) {
+                std::memcpy(current, input, literalCount);
+            }
+            input += literalCount;
+            current += literalCount;
+
+            // The last sequence has no match
+            if (input == inputEnd) break;
+
+            if (inputEnd - input < 2) return false;
+            size_t offset = input[0] | size_t(input[1]) << 8;
+            input += 2;
+            if (offset == 0 || offset > size_t(current - output)) return false;
+
+            size_t matchLength = token & 15;
+            if (matchLength == 15 && !readLength(input, inputEnd, matchLength)) return false;
+            matchLength += MinMatch;
+            if (matchLength > size_t(outputEnd - current)) return false;
+
+            const uint8_t *match = current - offset;
+            uint8_t *matchEnd = current + matchLength;
+            if (size_t(outputEnd - matchEnd) < WildCopy) {
+                // Near the end: copy byte by byte, which repeats overlapping patterns as intended
+                for (; current < matchEnd; current++, match++) {
+                    *current = *match;
+                }
+                continue;
+            }
+
+            if (offset < 8) {
+                // Repeat the pattern byte by byte until it spans at least 8 bytes, then copy whole repetitions
+                size_t period = offset * ((8 + offset - 1) / offset);
+                size_t count = std::min(period, matchLength);
+                for (size_t i = 0; i < count; i++) {
+                    current[i] = match[i];
+                }
+                current += count;
+                if (current == matchEnd) {
+                    // The whole match was shorter than a period, and current - period could be before the output
+                    continue;
+                }
+                match = current - period;
+            }
+
+            if (current - match >= 16) {
+                for (; current < matchEnd; current += 16, match += 16) {
+                    std::memcpy(current, match, 16);
+                }
+            } else {
+                for (; current < matchEnd; current += 8, match += 8) {
+                    std::memcpy(current, match, 8);
+                }
+            }
+            current = matchEnd;
+        }
+
+        return input == inputEnd && current == outputEnd;
+    }
+
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace zephyrus {
+
+    /// @brief LZ77 block compression for the chunk payloads of macro files
+    /// @note The block format is the one of LZ4: each sequence is a token (literal length and match length
+    /// in 4 bits each, 15 meaning that more length bytes follow), the literals, then a 2 byte match offset.
+    /// The last sequence only has literals. Blocks are independent and decompressed into a buffer of known size.
+    namespace BlockCodec {
+        /// @brief Compresses a block, appending the compressed bytes to the output
+        void compress(const uint8_t *data, size_t size, std::vector<uint8_t> &output);
+
+        /// @brief Decompresses a block into a buffer of the exact decompressed size
+        /// @return False if the block is corrupted or does not decompress to exactly that size
+        bool decompress(const uint8_t *data, size_t size, uint8_t *output, size_t outputSize);
+
+        /// @brief Maximum ratio between the decompressed and the compressed size of a block
+        constexpr size_t MaxRatio = 255;
+    }
+
+}
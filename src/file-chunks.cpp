@@ -0,0 +1,639 @@
+#include "file-chunks.hpp"
+
+#include "block-codec.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+namespace zephyrus::FileChunks {
+
+    namespace {
+        uint32_t countLeadingZeros(uint64_t value) {
+#if defined(_MSC_VER) && !defined(__clang__)
+            unsigned long index;
+            return _BitScanReverse64(&index, value) ? 63 - index : 64;
+#else
+            return value ? __builtin_clzll(value) : 64;
+#endif
+        }
+
+        uint32_t countTrailingZeros(uint64_t value) {
+#if defined(_MSC_VER) && !defined(__clang__)
+            unsigned long index;
+            return _BitScanForward64(&index, value) ? index : 64;
+#else
+            return value ? __builtin_ctzll(value) : 64;
+#endif
+        }
+
+        template<typename T>
+        uint64_t toBits(T value) {
+            std::conditional_t<sizeof(T) == 8, uint64_t, uint32_t> bits;
+            std::memcpy(&bits, &value, sizeof(T));
+            return bits;
+        }
+
+        template<typename T>
+        T fromBits(uint64_t bits) {
+            std::conditional_t<sizeof(T) == 8, uint64_t, uint32_t> value = bits;
+            T result;
+            std::memcpy(&result, &value, sizeof(T));
+            return result;
+        }
+
+        void writeVarInt(FileReader::BufferWriter &writer, uint32_t value) {
+            while (value >= 0x80) {
+                writer.write<uint8_t>(uint8_t(value) | 0x80);
+                value >>= 7;
+            }
+            writer.write<uint8_t>(uint8_t(value));
+        }
+
+        /// @brief Reads the LEB128 varints and raw bytes of a chunk payload, failing instead of overrunning it
+        class PayloadReader {
+        public:
+            PayloadReader(const uint8_t *data, size_t size) : m_data(data), m_size(size) {}
+
+            bool readVarInt(uint32_t &value) {
+                value = 0;
+                for (uint32_t shift = 0; shift < 35; shift += 7) {
+                    if (m_position == m_size) return false;
+                    uint8_t byte = m_data[m_position++];
+                    value |= uint32_t(byte & 0x7F) << shift;
+                    if (!(byte & 0x80)) return true;
+                }
+                return false;
+            }
+
+            const uint8_t *readBytes(size_t count) {
+                if (m_size - m_position < count) return nullptr;
+                const uint8_t *bytes = m_data + m_position;
+                m_position += count;
+                return bytes;
+            }
+
+            [[nodiscard]] const uint8_t *current() const { return m_data + m_position; }
+
+            [[nodiscard]] size_t remaining() const { return m_size - m_position; }
+
+        protected:
+            const uint8_t *m_data;
+            size_t m_size;
+            size_t m_position = 0;
+        };
+
+        /// @brief Appends bits to a buffer, most significant bit first
+        class BitWriter {
+        public:
+            explicit BitWriter(FileReader::BufferWriter &writer) : m_writer(writer) {}
+
+            void write(uint64_t value, uint32_t count) {
+                while (count > 0) {
+                    uint32_t space = 8 - m_used;
+                    uint32_t taken = count < space ? count : space;
+                    count -= taken;
+                    m_current |= uint8_t(((value >> count) & ((1u << taken) - 1)) << (space - taken));
+                    m_used += taken;
+                    if (m_used == 8) flush();
+                }
+            }
+
+            /// @brief Writes the last partial byte, padded with zeros
+            void flush() {
+                if (m_used == 0) return;
+                m_writer.write(m_current);
+                m_current = 0;
+                m_used = 0;
+            }
+
+        protected:
+            FileReader::BufferWriter &m_writer;
+            uint8_t m_current = 0;
+            uint32_t m_used = 0;
+        };
+
+        /// @brief Reads bits written by BitWriter, reading past the end yields zeros and sets the overrun flag
+        class BitReader {
+        public:
+            BitReader(const uint8_t *data, size_t size) : m_data(data), m_size(size) {}
+
+            uint64_t read(uint32_t count) {
+                uint64_t value = 0;
+                while (count > 0) {
+                    if (m_position == m_size) {
+                        m_overrun = true;
+                        return 0;
+                    }
+                    uint32_t available = 8 - m_used;
+                    uint32_t taken = count < available ? count : available;
+                    uint32_t bits = (m_data[m_position] >> (available - taken)) & ((1u << taken) - 1);
+                    value = (value << taken) | bits;
+                    count -= taken;
+                    m_used += taken;
+                    if (m_used == 8) {
+                        m_used = 0;
+                        m_position++;
+                    }
+                }
+                return value;
+            }
+
+            [[nodiscard]] bool overrun() const { return m_overrun; }
+
+        protected:
+            const uint8_t *m_data;
+            size_t m_size;
+            size_t m_position = 0;
+            uint32_t m_used = 0;
+            bool m_overrun = false;
+        };
+
+        /// @brief Number of bits that store the leading zero count and the length of a changed window
+        template<typename T>
+        constexpr uint32_t WindowFieldBits = sizeof(T) == 8 ? 6 : 5;
+
+        /// @brief XOR-encodes a column: unchanged values take one bit, and values that only differ within the
+        /// window of the previous difference skip storing its position again (Gorilla float compression)
+        template<typename T, typename Getter>
+        void encodeColumn(BitWriter &writer, size_t count, Getter get) {
+            constexpr uint32_t Width = sizeof(T) * 8;
+            constexpr uint32_t FieldBits = WindowFieldBits<T>;
+
+            uint64_t previous = 0;
+            uint32_t windowLeading = Width + 1; // No window yet
+            uint32_t windowTrailing = 0;
+            for (size_t i = 0; i < count; i++) {
+                uint64_t value = toBits<T>(get(i));
+                uint64_t difference = value ^ previous;
+                previous = value;
+
+                if (difference == 0) {
+                    writer.write(0, 1);
+                    continue;
+                }
+
+                uint32_t leading = countLeadingZeros(difference) - (64 - Width);
+                uint32_t trailing = countTrailingZeros(difference);
+                if (windowLeading <= Width && leading >= windowLeading && trailing >= windowTrailing) {
+                    writer.write(0b10, 2);
+                    writer.write(difference >> windowTrailing, Width - windowLeading - windowTrailing);
+                    continue;
+                }
+
+                uint32_t length = Width - leading - trailing;
+                writer.write(0b11, 2);
+                writer.write(leading, FieldBits);
+                writer.write(length - 1, FieldBits);
+                writer.write(difference >> trailing, length);
+                windowLeading = leading;
+                windowTrailing = trailing;
+            }
+        }
+
+        template<typename T, typename Setter>
+        void decodeColumn(BitReader &reader, size_t count, Setter set) {
+            constexpr uint32_t Width = sizeof(T) * 8;
+            constexpr uint32_t FieldBits = WindowFieldBits<T>;
+
+            uint64_t previous = 0;
+            uint32_t windowLeading = 0;
+            uint32_t windowTrailing = 0;
+            for (size_t i = 0; i < count; i++) {
+                if (reader.read(1)) {
+                    if (reader.read(1)) {
+                        windowLeading = uint32_t(reader.read(FieldBits));
+                        uint32_t length = uint32_t(reader.read(FieldBits)) + 1;
+                        // A corrupted window is clamped, the overrun check catches truncated streams
+                        if (windowLeading + length > Width) windowLeading = Width - length;
+                        windowTrailing = Width - windowLeading - length;
+                    }
+                    uint32_t length = Width - windowLeading - windowTrailing;
+                    previous ^= reader.read(length) << windowTrailing;
+                }
+                set(i, fromBits<T>(previous));
+            }
+        }
+
+        /// @brief Runs of equal values, stored as (value, length) pairs
+        struct Run {
+            uint32_t value;
+            uint32_t length;
+        };
+    }
+
+    std::vector<ChunkRange> splitIntoChunks(const Macro &macro) {
+        const auto &frames = macro.getFrames();
+        const auto &frameFixes = macro.getFrameFixes();
+
+        std::vector<ChunkRange> chunks;
+        ChunkRange chunk{};
+        size_t action = 0;
+        size_t frameFix = 0;
+        uint32_t lastFrame = 0;
+        while (action < frames.size() || frameFix < frameFixes.size()) {
+            // Merge walk over both lists, so that the chunk covers the same frames for actions and fixes
+            bool takeAction = frameFix == frameFixes.size() ||
+                              (action < frames.size() && frames[action].getFrame() <= frameFixes.getFrame(frameFix));
+            uint32_t frame = takeAction ? frames[action].getFrame() : frameFixes.getFrame(frameFix);
+
+            // Full chunks are closed at the next frame, so that frame ranges of chunks never overlap
+            bool full = chunk.actionCount >= MaxChunkEntries || chunk.frameFixCount >= MaxChunkEntries;
+            if (full && frame != lastFrame) {
+                chunks.push_back(chunk);
+                chunk = {action, 0, frameFix, 0};
+            }
+
+            if (takeAction) {
+                action++;
+                chunk.actionCount++;
+            } else {
+                frameFix++;
+                chunk.frameFixCount++;
+            }
+            lastFrame = frame;
+        }
+
+        if (chunk.actionCount || chunk.frameFixCount) {
+            chunks.push_back(chunk);
+        }
+        return chunks;
+    }
+
+    MacroFileChunk encodeChunk(const Macro &macro, const ChunkRange &range, FileReader::BufferWriter &writer,
+                               MacroFileCodec codec) {
+        const auto &frames = macro.getFrames();
+        const auto &frameFixes = macro.getFrameFixes();
+        const auto &player1 = frameFixes.getPlayer1Columns();
+        const auto &player2 = frameFixes.getPlayer2Columns();
+        const auto &player2Indices = frameFixes.getPlayer2Indices();
+
+        size_t actionEnd = range.firstAction + range.actionCount;
+        size_t frameFixEnd = range.firstFrameFix + range.frameFixCount;
+
+        MacroFileChunk header{};
+        header.firstFrame = UINT32_MAX;
+        if (range.actionCount) {
+            header.firstFrame = frames[range.firstAction].getFrame();
+            header.lastFrame = frames[actionEnd - 1].getFrame();
+        }
+        if (range.frameFixCount) {
+            header.firstFrame = std::min(header.firstFrame, frameFixes.getFrame(range.firstFrameFix));
+            header.lastFrame = std::max(header.lastFrame, frameFixes.getFrame(frameFixEnd - 1));
+        }
+        header.actionCount = range.actionCount;
+        header.frameFixCount = range.frameFixCount;
+
+        size_t headerPosition = writer.data().size();
+        writer.write(header.firstFrame);
+        writer.write(header.lastFrame);
+        writer.write(header.actionCount);
+        writer.write(header.frameFixCount);
+        writer.write(header.payloadSize); // Patched once the payload is written
+        size_t payloadPosition = writer.data().size();
+
+        // Actions: frame deltas, then the flags of every action
+        uint32_t previousFrame = header.firstFrame;
+        for (size_t i = range.firstAction; i < actionEnd; i++) {
+            writeVarInt(writer, frames[i].getFrame() - previousFrame);
+            previousFrame = frames[i].getFrame();
+        }
+        for (size_t i = range.firstAction; i < actionEnd; i++) {
+            writer.write(frames[i].getFlags());
+        }
+
+        // Frame fixes: run-length encoded frame deltas, fixes on every frame collapse into a single run
+        std::vector<Run> runs;
+        previousFrame = header.firstFrame;
+        for (size_t i = range.firstFrameFix; i < frameFixEnd; i++) {
+            uint32_t delta = frameFixes.getFrame(i) - previousFrame;
+            previousFrame = frameFixes.getFrame(i);
+            if (!runs.empty() && runs.back().value == delta) {
+                runs.back().length++;
+            } else {
+                runs.push_back({delta, 1});
+            }
+        }
+        writeVarInt(writer, uint32_t(runs.size()));
+        for (const auto &run : runs) {
+            writeVarInt(writer, run.value);
+            writeVarInt(writer, run.length);
+        }
+
+        // Player 2 presence: lengths of alternating runs, starting with fixes that have no player 2
+        size_t player2Begin = std::lower_bound(player2Indices.begin(), player2Indices.end(),
+                                               uint32_t(range.firstFrameFix)).getIndex();
+        size_t player2End = std::lower_bound(player2Indices.begin(), player2Indices.end(),
+                                             uint32_t(frameFixEnd)).getIndex();
+        runs.clear();
+        bool present = false;
+        uint32_t length = 0;
+        size_t player2Position = player2Begin;
+        for (size_t i = range.firstFrameFix; i < frameFixEnd; i++) {
+            bool player2Exists = player2Position < player2End && player2Indices[player2Position] == i;
+            if (player2Exists) player2Position++;
+            if (player2Exists != present) {
+                runs.push_back({0, length});
+                present = player2Exists;
+                length = 0;
+            }
+            length++;
+        }
+        if (range.frameFixCount) runs.push_back({0, length});
+        writeVarInt(writer, uint32_t(runs.size()));
+        for (const auto &run : runs) {
+            writeVarInt(writer, run.length);
+        }
+
+        // Player data columns, XOR-encoded into a single bit stream
+        BitWriter bits(writer);
+        auto encodePlayer = [&](const Macro::FrameFixStorage::PlayerColumns &columns, size_t begin, size_t count) {
+            encodeColumn<float>(bits, count, [&](size_t i) { return columns.x[begin + i]; });
+            encodeColumn<float>(bits, count, [&](size_t i) { return columns.y[begin + i]; });
+            encodeColumn<double>(bits, count, [&](size_t i) { return columns.ySpeed[begin + i]; });
+            encodeColumn<float>(bits, count, [&](size_t i) { return columns.rotation[begin + i]; });
+        };
+        encodePlayer(player1, range.firstFrameFix, range.frameFixCount);
+        encodePlayer(player2, player2Begin, player2End - player2Begin);
+        bits.flush();
+
+        if (codec == MacroFileCodec::LZ) {
+            // The decompressed size comes first, payloads that do not shrink are stored as they are after it
+            auto &data = writer.data();
+            size_t size = data.size() - payloadPosition;
+            std::vector<uint8_t> compressed;
+            BlockCodec::compress(data.data() + payloadPosition, size, compressed);
+            if (compressed.size() < size) {
+                data.resize(payloadPosition);
+                writer.write(uint32_t(size));
+                writer.append(compressed.data(), compressed.size());
+            } else {
+                writer.write(uint32_t(size));
+                std::rotate(data.begin() + payloadPosition, data.end() - 4, data.end());
+            }
+        }
+
+        header.payloadSize = uint32_t(writer.data().size() - payloadPosition);
+        writer.overwrite(headerPosition + 16, header.payloadSize);
+        return header;
+    }
+
+    bool unpackChunk(MacroFileChunk &chunk, const uint8_t *&payload, uint8_t codec, std::vector<uint8_t> &buffer) {
+        if (codec == uint8_t(MacroFileCodec::None)) {
+            return true;
+        }
+        if (codec != uint8_t(MacroFileCodec::LZ) || chunk.payloadSize < 4) {
+            return false;
+        }
+
+        FileReader::BufferReader reader(payload, chunk.payloadSize);
+        uint32_t size = reader.read<uint32_t>();
+        uint32_t storedSize = chunk.payloadSize - 4;
+        if (size == storedSize) {
+            // Stored without compression
+            payload += 4;
+            chunk.payloadSize = size;
+            return true;
+        }
+        if (size > uint64_t(storedSize) * BlockCodec::MaxRatio) {
+            return false;
+        }
+
+        buffer.resize(size);
+        if (!BlockCodec::decompress(payload + 4, storedSize, buffer.data(), size)) {
+            return false;
+        }
+        payload = buffer.data();
+        chunk.payloadSize = size;
+        return true;
+    }
+
+    MacroFileChunk readChunkHeader(FileReader::BufferReader &reader) {
+        MacroFileChunk chunk{};
+        chunk.firstFrame = reader.read<uint32_t>();
+        chunk.lastFrame = reader.read<uint32_t>();
+        chunk.actionCount = reader.read<uint32_t>();
+        chunk.frameFixCount = reader.read<uint32_t>();
+        chunk.payloadSize = reader.read<uint32_t>();
+        return chunk;
+    }
+
+    namespace {
+        /// @brief Decodes a chunk payload, passing every action and frame fix to the callbacks in order
+        template<typename ActionCallback, typename FrameFixCallback>
+        bool decodeEntries(const MacroFileChunk &chunk, const uint8_t *payload, ActionCallback onAction,
+                           FrameFixCallback onFrameFix) {
+            PayloadReader reader(payload, chunk.payloadSize);
+
+            // Every action and fix takes at least one byte or one bit, which rejects broken counts before allocating
+            if (chunk.firstFrame > chunk.lastFrame || chunk.actionCount > chunk.payloadSize ||
+                chunk.frameFixCount / 8 > chunk.payloadSize) {
+                return false;
+            }
+
+            // Actions
+            std::vector<uint32_t> frames(chunk.actionCount);
+            uint32_t frame = chunk.firstFrame;
+            for (auto &actionFrame : frames) {
+                uint32_t delta;
+                if (!reader.readVarInt(delta) || delta > chunk.lastFrame - frame) return false;
+                frame += delta;
+                actionFrame = frame;
+            }
+            const uint8_t *flags = reader.readBytes(chunk.actionCount);
+            if (!flags) return false;
+
+            // Frame fixes
+            std::vector<uint32_t> fixFrames;
+            fixFrames.reserve(chunk.frameFixCount);
+            uint32_t runCount;
+            if (!reader.readVarInt(runCount)) return false;
+            frame = chunk.firstFrame;
+            for (uint32_t run = 0; run < runCount; run++) {
+                uint32_t delta, length;
+                if (!reader.readVarInt(delta) || !reader.readVarInt(length)) return false;
+                if (length > chunk.frameFixCount - fixFrames.size()) return false;
+                for (uint32_t i = 0; i < length; i++) {
+                    if (delta > chunk.lastFrame - frame) return false;
+                    frame += delta;
+                    fixFrames.push_back(frame);
+                }
+            }
+            if (fixFrames.size() != chunk.frameFixCount) return false;
+
+            std::vector<bool> player2Exists;
+            player2Exists.reserve(chunk.frameFixCount);
+            size_t player2Count = 0;
+            if (!reader.readVarInt(runCount)) return false;
+            for (uint32_t run = 0; run < runCount; run++) {
+                uint32_t length;
+                if (!reader.readVarInt(length) || length > chunk.frameFixCount - player2Exists.size()) return false;
+                bool present = run % 2 == 1;
+                player2Exists.insert(player2Exists.end(), length, present);
+                if (present) player2Count += length;
+            }
+            if (player2Exists.size() != chunk.frameFixCount) return false;
+
+            std::vector<Macro::FrameFix::PlayerData> player1(chunk.frameFixCount);
+            std::vector<Macro::FrameFix::PlayerData> player2(player2Count);
+            BitReader bits(reader.current(), reader.remaining());
+            auto decodePlayer = [&](std::vector<Macro::FrameFix::PlayerData> &data) {
+                decodeColumn<float>(bits, data.size(), [&](size_t i, float value) { data[i].x = value; });
+                decodeColumn<float>(bits, data.size(), [&](size_t i, float value) { data[i].y = value; });
+                decodeColumn<double>(bits, data.size(), [&](size_t i, double value) { data[i].ySpeed = value; });
+                decodeColumn<float>(bits, data.size(), [&](size_t i, float value) { data[i].rotation = value; });
+            };
+            decodePlayer(player1);
+            decodePlayer(player2);
+            if (bits.overrun()) return false;
+
+            for (size_t i = 0; i < frames.size(); i++) {
+                onAction(frames[i], flags[i]);
+            }
+
+            size_t player2Position = 0;
+            for (size_t i = 0; i < fixFrames.size(); i++) {
+                onFrameFix(fixFrames[i], player1[i], player2Exists[i] ? &player2[player2Position++] : nullptr);
+            }
+
+            return true;
+        }
+    }
+
+    bool decodeChunk(const MacroFileChunk &chunk, const uint8_t *payload, std::vector<Macro::Frame> &actions,
+                     std::vector<Macro::FrameFix> &frameFixes) {
+        actions.reserve(actions.size() + chunk.actionCount);
+        frameFixes.reserve(frameFixes.size() + chunk.frameFixCount);
+        return decodeEntries(chunk, payload, [&](uint32_t frame, uint8_t flags) {
+            actions.emplace_back(frame, flags);
+        }, [&](uint32_t frame, const Macro::FrameFix::PlayerData &player1, const Macro::FrameFix::PlayerData *player2) {
+            if (player2) {
+                frameFixes.emplace_back(frame, player1, *player2);
+            } else {
+                frameFixes.emplace_back(frame, player1);
+            }
+        });
+    }
+
+    bool decodeChunk(const MacroFileChunk &chunk, const uint8_t *payload, Macro &macro,
+                     uint32_t startFrame, uint32_t endFrame) {
+        return decodeEntries(chunk, payload, [&](uint32_t frame, uint8_t flags) {
+            if (frame >= startFrame && frame <= endFrame) macro.addFrame(frame, flags);
+        }, [&](uint32_t frame, const Macro::FrameFix::PlayerData &player1, const Macro::FrameFix::PlayerData *player2) {
+            if (frame < startFrame || frame > endFrame) return;
+            if (player2) {
+                macro.addFrameFix(frame, player1, *player2);
+            } else {
+                macro.addFrameFix(frame, player1);
+            }
+        });
+    }
+
+    bool decodeChunk(const MacroFileChunk &chunk, const uint8_t *payload, Macro &macro, const ChunkRange &range,
+                     std::vector<std::pair<size_t, Macro::FrameFix::PlayerData>> &player2) {
+        if (chunk.actionCount != range.actionCount || chunk.frameFixCount != range.frameFixCount) {
+            return false;
+        }
+
+        size_t action = range.firstAction;
+        size_t frameFix = range.firstFrameFix;
+        return decodeEntries(chunk, payload, [&](uint32_t frame, uint8_t flags) {
+            macro.setFrame(action++, frame, flags);
+        }, [&](uint32_t frame, const Macro::FrameFix::PlayerData &player1, const Macro::FrameFix::PlayerData *data) {
+            if (data) player2.emplace_back(frameFix, *data);
+            macro.setFrameFix(frameFix++, frame, player1);
+        });
+    }
+
+    void writeIndex(FileReader::BufferWriter &writer, const std::vector<MacroFileIndexEntry> &index) {
+        uint64_t indexOffset = writer.data().size();
+        for (const auto &entry : index) {
+            writer.write(entry.firstFrame);
+            writer.write(entry.lastFrame);
+            writer.write(entry.offset);
+            writer.write(entry.firstAction);
+            writer.write(entry.firstFrameFix);
+        }
+        writer.write(indexOffset);
+        writer.write(FooterMagic);
+    }
+
+    MacroFileIndexEntry readIndexEntry(FileReader::BufferReader &reader) {
+        MacroFileIndexEntry entry{};
+        entry.firstFrame = reader.read<uint32_t>();
+        entry.lastFrame = reader.read<uint32_t>();
+        entry.offset = reader.read<uint64_t>();
+        entry.firstAction = reader.read<uint32_t>();
+        entry.firstFrameFix = reader.read<uint32_t>();
+        return entry;
+    }
+
+    namespace {
+        /// @brief Reads the footer, checking that an index of that many chunks fits before it
+        bool readFooter(const uint8_t *footer, uint64_t fileSize, uint32_t chunkCount, uint64_t &indexOffset) {
+            FileReader::BufferReader reader(footer, FooterSize);
+            indexOffset = reader.read<uint64_t>();
+            return reader.read<uint32_t>() == FooterMagic && indexOffset >= FileReader::FileHeaderV3Size &&
+                   fileSize - FooterSize - indexOffset == chunkCount * uint64_t(IndexEntrySize);
+        }
+
+        /// @brief Reads the index entries, checking that they are in file and frame order
+        bool readIndexEntries(const uint8_t *data, uint32_t chunkCount, uint64_t indexOffset,
+                              std::vector<MacroFileIndexEntry> &index) {
+            FileReader::BufferReader reader(data, chunkCount * size_t(IndexEntrySize));
+            index.clear();
+            index.reserve(chunkCount);
+            uint64_t previousOffset = 0;
+            uint32_t previousFrame = 0;
+            for (uint32_t i = 0; i < chunkCount; i++) {
+                auto entry = readIndexEntry(reader);
+                // Chunks have to be in file and frame order for the binary search
+                if (entry.offset < std::max<uint64_t>(previousOffset, FileReader::FileHeaderV3Size) ||
+                    entry.offset >= indexOffset || entry.firstFrame < previousFrame || entry.lastFrame < entry.firstFrame) {
+                    return false;
+                }
+                previousOffset = entry.offset + ChunkHeaderSize;
+                previousFrame = entry.lastFrame;
+                index.push_back(entry);
+            }
+            return true;
+        }
+    }
+
+    bool readIndex(std::ifstream &file, uint64_t fileSize, uint32_t chunkCount,
+                   std::vector<MacroFileIndexEntry> &index, uint64_t &indexOffset) {
+        std::vector<uint8_t> data;
+        if (fileSize < FileReader::FileHeaderV3Size + FooterSize ||
+            !FileReader::readFileRange(file, fileSize - FooterSize, FooterSize, data) ||
+            !readFooter(data.data(), fileSize, chunkCount, indexOffset)) {
+            return false;
+        }
+
+        return FileReader::readFileRange(file, indexOffset, chunkCount * size_t(IndexEntrySize), data) &&
+               readIndexEntries(data.data(), chunkCount, indexOffset, index);
+    }
+
+    bool readIndex(const uint8_t *data, uint64_t fileSize, uint32_t chunkCount,
+                   std::vector<MacroFileIndexEntry> &index, uint64_t &indexOffset) {
+        return fileSize >= FileReader::FileHeaderV3Size + FooterSize &&
+               readFooter(data + fileSize - FooterSize, fileSize, chunkCount, indexOffset) &&
+               readIndexEntries(data + indexOffset, chunkCount, indexOffset, index);
+    }
+
+    std::pair<size_t, size_t> findChunks(const std::vector<MacroFileIndexEntry> &index,
+                                         uint32_t startFrame, uint32_t endFrame) {
+        // Chunks are sorted and never overlap, so both ends can be found with a binary search
+        auto first = std::partition_point(index.begin(), index.end(), [&](const MacroFileIndexEntry &entry) {
+            return entry.lastFrame < startFrame;
+        });
+        auto last = std::partition_point(first, index.end(), [&](const MacroFileIndexEntry &entry) {
+            return entry.firstFrame <= endFrame;
+        });
+        return {size_t(first - index.begin()), size_t(last - index.begin())};
+    }
+
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include <zephyrus/file-io.hpp>
+
+#include "file-reader.hpp"
+
+namespace zephyrus {
+
+    /// @brief Utility namespace for the chunks of version 3 macro files
+    namespace FileChunks {
+        constexpr size_t ChunkHeaderSize = 5 * 4;
+        constexpr size_t IndexEntrySize = 4 + 4 + 8 + 4 + 4;
+        constexpr size_t FooterSize = 8 + 4; // Index offset, then the magic number
+        constexpr uint32_t FooterMagic = 0x5852495A; // "ZIRX"
+
+        /// @brief Chunks are closed once they reach this many actions or frame fixes
+        constexpr size_t MaxChunkEntries = 4096;
+
+        /// @brief Position of the entries of a chunk in a macro
+        struct ChunkRange {
+            size_t firstAction{};
+            size_t actionCount{};
+            size_t firstFrameFix{};
+            size_t frameFixCount{};
+        };
+
+        /// @brief Splits a macro into chunks, keeping actions and frame fixes of each chunk in the same frame range
+        std::vector<ChunkRange> splitIntoChunks(const Macro &macro);
+
+        /// @brief Returns whether the chunk payloads of a file with that codec can be decoded
+        constexpr bool isSupportedCodec(uint8_t codec) { return codec <= uint8_t(MacroFileCodec::LZ); }
+
+        /// @brief Encodes the chunk header and payload of a range of a macro
+        /// @return The chunk header that was written
+        MacroFileChunk encodeChunk(const Macro &macro, const ChunkRange &range, FileReader::BufferWriter &writer,
+                                   MacroFileCodec codec = MacroFileCodec::None);
+
+        /// @brief Decompresses a chunk payload as stored in the file, so that it can be decoded
+        /// @param chunk The chunk header, its payload size is replaced by the size of the decompressed payload
+        /// @param payload The payload, replaced by the decompressed payload (in the buffer) if it is compressed
+        /// @return False if the payload is corrupted
+        bool unpackChunk(MacroFileChunk &chunk, const uint8_t *&payload, uint8_t codec, std::vector<uint8_t> &buffer);
+
+        /// @brief Reads a chunk header (check `has(ChunkHeaderSize)` first)
+        MacroFileChunk readChunkHeader(FileReader::BufferReader &reader);
+
+        /// @brief Decodes a chunk payload and appends its entries to the arrays
+        /// @return False if the payload is corrupted
+        bool decodeChunk(const MacroFileChunk &chunk, const uint8_t *payload, std::vector<Macro::Frame> &actions,
+                         std::vector<Macro::FrameFix> &frameFixes);
+
+        /// @brief Decodes a chunk payload and appends its entries within a frame window to the macro
+        /// @return False if the payload is corrupted
+        bool decodeChunk(const MacroFileChunk &chunk, const uint8_t *payload, Macro &macro,
+                         uint32_t startFrame = 0, uint32_t endFrame = UINT32_MAX);
+
+        /// @brief Decodes a chunk payload into its range of a macro that is being loaded (see Macro::resizeForLoad)
+        /// @note Chunks can be decoded concurrently. Player 2 data is collected with the index of its fix instead,
+        /// since it has to be added to the macro in order (see Macro::setFrameFixPlayer2).
+        /// @return False if the payload is corrupted or does not match the range
+        bool decodeChunk(const MacroFileChunk &chunk, const uint8_t *payload, Macro &macro, const ChunkRange &range,
+                         std::vector<std::pair<size_t, Macro::FrameFix::PlayerData>> &player2);
+
+        /// @brief Writes the index of the chunks and the footer that points to it
+        void writeIndex(FileReader::BufferWriter &writer, const std::vector<MacroFileIndexEntry> &index);
+
+        /// @brief Reads an index entry (check `has(IndexEntrySize)` first)
+        MacroFileIndexEntry readIndexEntry(FileReader::BufferReader &reader);
+
+        /// @brief Reads the footer and the index of a version 3 macro file, checking that the index is consistent
+        /// @return False if the file has no index or if it is corrupted
+        bool readIndex(std::ifstream &file, uint64_t fileSize, uint32_t chunkCount,
+                       std::vector<MacroFileIndexEntry> &index, uint64_t &indexOffset);
+
+        /// @brief Reads the footer and the index of a version 3 macro file held in memory
+        /// @return False if the file has no index or if it is corrupted
+        bool readIndex(const uint8_t *data, uint64_t fileSize, uint32_t chunkCount,
+                       std::vector<MacroFileIndexEntry> &index, uint64_t &indexOffset);
+
+        /// @brief Returns the range of index entries whose chunks overlap a frame window
+        std::pair<size_t, size_t> findChunks(const std::vector<MacroFileIndexEntry> &index,
+                                             uint32_t startFrame, uint32_t endFrame);
+    }
+
+}
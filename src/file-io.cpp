@@ -1,157 +1,463 @@
 #include <zephyrus/file-io.hpp>
 
+#include <algorithm>
+#include <cstring>
 #include <fstream>
 #include <bit>
 #include <iostream>
 
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 #include <zephyrus/formats/gdreplay.hpp>
 
+#include "block-codec.hpp"
+#include "file-chunks.hpp"
+#include "file-reader.hpp"
+#include "parallel.hpp"
+
 namespace zephyrus {
 
-    /// @brief Utility namespace for reading files using little endian
     namespace FileReader {
-        bool isBigEndian()
-        {
-            union {
-                uint32_t i;
-                char c[4];
-            } bInt = {0x01020304};
-            return bInt.c[0] == 1;
-        }
-
-        /// @brief Reads a value from a file using little endian
-        template<typename T>
-        T read(std::ifstream &file) {
-            T value;
-            file.read(reinterpret_cast<char *>(&value), sizeof(T));
-
-            // If the system is big endian, swap the bytes
-            if (isBigEndian()) {
-                for (size_t i = 0; i < sizeof(T) / 2; i++) {
-                    std::swap(reinterpret_cast<char *>(&value)[i], reinterpret_cast<char *>(&value)[sizeof(T) - i - 1]);
-                }
+        bool readWholeFile(const std::filesystem::path &path, std::vector<uint8_t> &data, Progress *progress) {
+            std::error_code error;
+            auto size = std::filesystem::file_size(path, error);
+            if (error) {
+                return false;
+            }
+
+            std::ifstream file(path, std::ios::binary);
+            if (!file.is_open()) {
+                return false;
+            }
+
+            data.resize(size);
+            if (!progress) {
+                file.read(reinterpret_cast<char *>(data.data()), static_cast<std::streamsize>(size));
+                return static_cast<size_t>(file.gcount()) == size;
             }
 
-            return value;
+            // Read in blocks, so that progress can be reported and the read cancelled
+            progress->bytesTotal.store(size, std::memory_order_relaxed);
+            for (size_t offset = 0; offset < size; offset += ProgressBlockSize) {
+                if (isCancelled(progress)) {
+                    return false;
+                }
+
+                size_t count = std::min(ProgressBlockSize, size - offset);
+                file.read(reinterpret_cast<char *>(data.data() + offset), static_cast<std::streamsize>(count));
+                if (static_cast<size_t>(file.gcount()) != count) {
+                    return false;
+                }
+                progress->bytesDone.fetch_add(count, std::memory_order_relaxed);
+            }
+            return true;
         }
 
-        double readDouble(std::ifstream &file) {
-            double value;
-            file.read(reinterpret_cast<char *>(&value), sizeof(double));
-            return value;
+        bool readFileRange(std::ifstream &file, uint64_t offset, size_t size, std::vector<uint8_t> &data) {
+            data.resize(size);
+            file.clear();
+            file.seekg(static_cast<std::streamoff>(offset));
+            file.read(reinterpret_cast<char *>(data.data()), static_cast<std::streamsize>(size));
+            return static_cast<size_t>(file.gcount()) == size;
         }
 
-        float readSingle(std::ifstream &file) {
-            float value;
-            file.read(reinterpret_cast<char *>(&value), sizeof(float));
-            return value;
+        std::filesystem::path getTemporaryPath(const std::filesystem::path &path) {
+            auto temporaryPath = path;
+            temporaryPath += ".tmp";
+            return temporaryPath;
         }
 
-        Macro::FrameFix::PlayerData readPlayerData(std::ifstream &file) {
-            Macro::FrameFix::PlayerData data{};
-            data.x = FileReader::readSingle(file);
-            data.y = FileReader::readSingle(file);
-            data.ySpeed = FileReader::readDouble(file);
-            data.rotation = FileReader::readSingle(file);
-            return data;
+        bool syncFile(const std::filesystem::path &path) {
+#ifdef _WIN32
+            HANDLE file = CreateFileW(path.c_str(), GENERIC_WRITE, 0, nullptr, OPEN_EXISTING,
+                                      FILE_ATTRIBUTE_NORMAL, nullptr);
+            if (file == INVALID_HANDLE_VALUE) {
+                return false;
+            }
+            bool synced = FlushFileBuffers(file) != 0;
+            CloseHandle(file);
+            return synced;
+#else
+            int file = ::open(path.c_str(), O_WRONLY);
+            if (file < 0) {
+                return false;
+            }
+            bool synced = ::fsync(file) == 0;
+            ::close(file);
+            return synced;
+#endif
         }
 
-        MacroFileHeader readFileHeader(std::ifstream &file) {
-            MacroFileHeader header{};
-            header.magic = FileReader::read<uint16_t>(file);
-            header.version = FileReader::read<uint8_t>(file);
-            header.recordedFPS = FileReader::read<uint32_t>(file);
-            header.actionCount = FileReader::read<uint32_t>(file);
-            header.frameFixCount = FileReader::read<uint32_t>(file);
-            return header;
+        bool commitTemporaryFile(const std::filesystem::path &temporaryPath, const std::filesystem::path &path) {
+            std::error_code error;
+
+            // The data has to be on the disk before the rename is, or a crash could leave an empty destination
+            if (!syncFile(temporaryPath)) {
+                std::filesystem::remove(temporaryPath, error);
+                return false;
+            }
+
+            // Renaming replaces the destination atomically, readers see either the old or the new file
+            std::filesystem::rename(temporaryPath, path, error);
+            if (error) {
+                std::filesystem::remove(temporaryPath, error);
+                return false;
+            }
+            return true;
         }
 
-        MacroFileAction readFileAction(std::ifstream &file) {
-            MacroFileAction action{};
-            action.frame = FileReader::read<uint32_t>(file);
-            action.flags = FileReader::read<uint8_t>(file);
-            return action;
-        }
-
-        /// @brief Writes a value to a file using little endian
-        template<typename T>
-        void write(std::ofstream &file, T value) {
-            // If the system is big endian, swap the bytes
-            if (isBigEndian()) {
-                for (size_t i = 0; i < sizeof(T) / 2; i++) {
-                    std::swap(reinterpret_cast<char *>(&value)[i], reinterpret_cast<char *>(&value)[sizeof(T) - i - 1]);
+        bool writeWholeFile(const std::filesystem::path &path, const uint8_t *data, size_t size, Progress *progress) {
+            auto temporaryPath = getTemporaryPath(path);
+
+            {
+                std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+                if (!file.is_open()) {
+                    return false;
+                }
+
+                // Without progress this is a single write
+                size_t blockSize = progress ? ProgressBlockSize : size;
+                if (progress) {
+                    progress->bytesTotal.store(size, std::memory_order_relaxed);
+                }
+
+                for (size_t offset = 0; offset < size && file.good() && !isCancelled(progress); offset += blockSize) {
+                    size_t count = std::min(blockSize, size - offset);
+                    file.write(reinterpret_cast<const char *>(data + offset), static_cast<std::streamsize>(count));
+                    if (progress) {
+                        progress->bytesDone.fetch_add(count, std::memory_order_relaxed);
+                    }
+                }
+                file.flush();
+                if (!file.good() || isCancelled(progress)) {
+                    file.close();
+                    std::error_code error;
+                    std::filesystem::remove(temporaryPath, error);
+                    return false;
                 }
             }
 
-            file.write(reinterpret_cast<char *>(&value), sizeof(T));
+            return commitTemporaryFile(temporaryPath, path);
         }
+    }
 
-        void write(std::ofstream &file, double value) {
-            file.write(reinterpret_cast<char *>(&value), sizeof(double));
-        }
+    namespace {
+        /// @brief Reads the chunks of a version 3 macro file
+        bool readChunks(FileReader::BufferReader &reader, const MacroFileHeader &header, const uint8_t *data,
+                        Macro &macro, FileReader::Progress *progress) {
+            if (reader.position() < FileReader::FileHeaderV3Size || !FileChunks::isSupportedCodec(header.codec)) {
+                return false;
+            }
 
-        void write(std::ofstream &file, float value) {
-            file.write(reinterpret_cast<char *>(&value), sizeof(float));
+            // Every chunk has at least one entry, actions take at least two bytes and fixes at least four bits
+            // (before compression), which allows rejecting broken counts before allocating
+            uint64_t payloadSize = header.actionCount * uint64_t(2) + header.frameFixCount / 2;
+            if (header.codec == uint8_t(MacroFileCodec::LZ)) {
+                payloadSize = payloadSize / BlockCodec::MaxRatio + header.chunkCount * uint64_t(4);
+            }
+            if (header.chunkCount > uint64_t(header.actionCount) + header.frameFixCount ||
+                !reader.has(header.chunkCount * FileChunks::ChunkHeaderSize + payloadSize)) {
+                return false;
+            }
+
+            // Walk the chunk headers first, so that the payloads can be decoded in any order, straight into their
+            // position in the macro
+            struct Chunk {
+                MacroFileChunk header;
+                const uint8_t *payload;
+                FileChunks::ChunkRange range;
+            };
+            std::vector<Chunk> chunks;
+            chunks.reserve(header.chunkCount);
+            uint64_t actionCount = 0;
+            uint64_t frameFixCount = 0;
+            uint32_t lastFrame = 0;
+            for (uint32_t i = 0; i < header.chunkCount; i++) {
+                if (!reader.has(FileChunks::ChunkHeaderSize)) {
+                    return false;
+                }
+
+                // Chunks never overlap, so that the entries of the macro end up sorted by frame
+                MacroFileChunk chunk = FileChunks::readChunkHeader(reader);
+                if (!reader.has(chunk.payloadSize) || chunk.firstFrame < lastFrame) {
+                    return false;
+                }
+                lastFrame = chunk.lastFrame;
+                FileChunks::ChunkRange range{actionCount, chunk.actionCount, frameFixCount, chunk.frameFixCount};
+                chunks.push_back({chunk, data + reader.position(), range});
+                actionCount += chunk.actionCount;
+                frameFixCount += chunk.frameFixCount;
+                reader.skip(chunk.payloadSize);
+            }
+            if (actionCount != header.actionCount || frameFixCount != header.frameFixCount) {
+                return false;
+            }
+
+            macro.resizeForLoad(header.actionCount, header.frameFixCount);
+
+            // Workers decode the chunks into the macro, only player 2 data has to be added in order on this thread
+            struct DecodedChunk {
+                std::vector<std::pair<size_t, Macro::FrameFix::PlayerData>> player2;
+                std::vector<uint8_t> buffer;
+            };
+            size_t workerCount = Parallel::getWorkerCount(chunks.size());
+            std::vector<DecodedChunk> slots(Parallel::getSlotCount(workerCount));
+
+            bool success = Parallel::runOrdered(chunks.size(), workerCount, slots.size(), [&](size_t task, size_t slot) {
+                auto chunk = chunks[task];
+                auto &decoded = slots[slot];
+                decoded.player2.clear();
+                return !FileReader::isCancelled(progress) &&
+                       FileChunks::unpackChunk(chunk.header, chunk.payload, header.codec, decoded.buffer) &&
+                       FileChunks::decodeChunk(chunk.header, chunk.payload, macro, chunk.range, decoded.player2);
+            }, [&](size_t task, size_t slot) {
+                for (const auto &[index, player2] : slots[slot].player2) {
+                    macro.setFrameFixPlayer2(index, player2);
+                }
+                FileReader::addRecords(progress, chunks[task].range.actionCount + chunks[task].range.frameFixCount);
+                return true;
+            });
+            if (!success) {
+                macro.clearFrames();
+                return false;
+            }
+
+            macro.finishLoad();
+            return true;
         }
 
-        void writePlayerData(std::ofstream &file, const Macro::FrameFix::PlayerData &data) {
-            FileReader::write(file, data.x);
-            FileReader::write(file, data.y);
-            FileReader::write(file, data.ySpeed);
-            FileReader::write(file, data.rotation);
+        /// @brief Writes a version 3 macro file: the header, independently decodable chunks, then their index
+        bool writeChunks(const Macro &macro, const std::filesystem::path &path, MacroFileCodec codec,
+                         FileReader::Progress *progress) {
+            auto chunks = FileChunks::splitIntoChunks(macro);
+            if (progress) {
+                progress->recordsTotal.store(macro.getFrames().size() + uint64_t(macro.getFrameFixes().size()));
+            }
+
+            MacroFileHeader header{};
+            header.magic = 0x525A;
+            header.version = 3;
+            header.recordedFPS = 240;
+            header.actionCount = macro.getFrames().size();
+            header.frameFixCount = macro.getFrameFixes().size();
+            header.chunkCount = chunks.size();
+            header.codec = uint8_t(codec);
+
+            // Encoded entries are usually much smaller than in version 2, a quarter of that is a good first guess
+            FileReader::BufferWriter writer(FileReader::FileHeaderV3Size +
+                                            chunks.size() * (FileChunks::ChunkHeaderSize + FileChunks::IndexEntrySize) +
+                                            FileChunks::FooterSize +
+                                            header.actionCount * FileReader::FileActionSize / 4 +
+                                            header.frameFixCount * FileReader::FileFrameFixSize / 4);
+
+            FileReader::writeFileHeader(writer, header);
+
+            // Chunks are encoded on worker threads, then appended to the file in order on this one
+            struct EncodedChunk {
+                FileReader::BufferWriter writer;
+                MacroFileChunk header;
+            };
+            size_t workerCount = Parallel::getWorkerCount(chunks.size());
+            std::vector<EncodedChunk> slots(Parallel::getSlotCount(workerCount));
+
+            std::vector<MacroFileIndexEntry> index;
+            index.reserve(chunks.size());
+            bool success = Parallel::runOrdered(chunks.size(), workerCount, slots.size(), [&](size_t task, size_t slot) {
+                auto &encoded = slots[slot];
+                encoded.writer.data().clear();
+                encoded.header = FileChunks::encodeChunk(macro, chunks[task], encoded.writer, codec);
+                return !FileReader::isCancelled(progress);
+            }, [&](size_t task, size_t slot) {
+                const auto &encoded = slots[slot];
+                const auto &chunk = chunks[task];
+                MacroFileIndexEntry entry{};
+                entry.offset = writer.data().size();
+                entry.firstAction = chunk.firstAction;
+                entry.firstFrameFix = chunk.firstFrameFix;
+                entry.firstFrame = encoded.header.firstFrame;
+                entry.lastFrame = encoded.header.lastFrame;
+                index.push_back(entry);
+
+                writer.append(encoded.writer.data().data(), encoded.writer.data().size());
+                FileReader::addRecords(progress, chunk.actionCount + uint64_t(chunk.frameFixCount));
+                return true;
+            });
+            if (!success) {
+                return false;
+            }
+            FileChunks::writeIndex(writer, index);
+
+            return FileReader::writeWholeFile(path, writer.data().data(), writer.data().size(), progress);
         }
 
-        void writeFileHeader(std::ofstream &file, const MacroFileHeader &header) {
-            FileReader::write(file, header.magic);
-            FileReader::write(file, header.version);
-            FileReader::write(file, header.recordedFPS);
-            FileReader::write(file, header.actionCount);
-            FileReader::write(file, header.frameFixCount);
+        /// @brief Reads the header and the chunk index of a version 3 macro file, without reading the chunks
+        bool readFileIndex(std::ifstream &file, uint64_t fileSize, MacroFileHeader &header,
+                           std::vector<MacroFileIndexEntry> &index, uint64_t &indexOffset) {
+            std::vector<uint8_t> data;
+            if (fileSize < FileReader::FileHeaderV3Size ||
+                !FileReader::readFileRange(file, 0, FileReader::FileHeaderV3Size, data)) {
+                return false;
+            }
+
+            FileReader::BufferReader reader(data.data(), data.size());
+            header = FileReader::readFileHeader(reader);
+            if (header.magic != 0x525A || header.version != 3 || !FileChunks::isSupportedCodec(header.codec)) {
+                return false;
+            }
+
+            return FileChunks::readIndex(file, fileSize, header.chunkCount, index, indexOffset);
         }
 
-        void writeFileAction(std::ofstream &file, const MacroFileAction &action) {
-            FileReader::write(file, action.frame);
-            FileReader::write(file, action.flags);
+        /// @brief Reads the chunks of a version 3 macro file that overlap a frame window
+        /// @return False if the file is not a version 3 file with an index, or if it is corrupted
+        bool readIndexedWindow(const std::filesystem::path &path, Macro &macro, uint32_t startFrame, uint32_t endFrame) {
+            std::error_code error;
+            auto fileSize = std::filesystem::file_size(path, error);
+            if (error) {
+                return false;
+            }
+
+            std::ifstream file(path, std::ios::binary);
+            MacroFileHeader header{};
+            std::vector<MacroFileIndexEntry> index;
+            uint64_t indexOffset = 0;
+            if (!file.is_open() || !readFileIndex(file, fileSize, header, index, indexOffset)) {
+                return false;
+            }
+
+            macro.clearFrames();
+            auto [first, last] = FileChunks::findChunks(index, startFrame, endFrame);
+            if (first == last) {
+                return true;
+            }
+
+            // The selected chunks are contiguous, so they are read with a single read
+            uint64_t begin = index[first].offset;
+            uint64_t end = last < index.size() ? index[last].offset : indexOffset;
+            std::vector<uint8_t> data;
+            if (!FileReader::readFileRange(file, begin, end - begin, data)) {
+                return false;
+            }
+
+            FileReader::BufferReader reader(data.data(), data.size());
+            std::vector<uint8_t> buffer;
+            for (size_t i = first; i < last; i++) {
+                if (!reader.has(FileChunks::ChunkHeaderSize)) {
+                    return false;
+                }
+
+                MacroFileChunk chunk = FileChunks::readChunkHeader(reader);
+                if (!reader.has(chunk.payloadSize)) {
+                    return false;
+                }
+                size_t storedSize = chunk.payloadSize;
+                const uint8_t *payload = data.data() + reader.position();
+                if (!FileChunks::unpackChunk(chunk, payload, header.codec, buffer) ||
+                    !FileChunks::decodeChunk(chunk, payload, macro, startFrame, endFrame)) {
+                    return false;
+                }
+                reader.skip(storedSize);
+            }
+            return true;
         }
     }
 
     bool readFromFile(const std::filesystem::path &path, Macro &macro) {
+        return FileReader::readMacroFile(path, macro, nullptr);
+    }
+
+    bool FileReader::readMacroFile(const std::filesystem::path &path, Macro &macro, Progress *progress) {
         // Check if the file exists
         if (!std::filesystem::exists(path)) {
             return false;
         }
 
         // Deduce file format from file extension
-        std::string extension = path.extension().string();
-        if (extension == ".gdr") // Read GDReplay file
-            return formats::GDR::readFromFile(path, macro);
+        if (formats::GDR::isReplayPath(path)) { // Read GDReplay file
+            // The parser reports no progress, so the whole file counts as done at the end
+            bool success = !isCancelled(progress) && formats::GDR::readFromFile(path, macro) && !isCancelled(progress);
+            if (success && progress) {
+                progress->recordsDone.store(macro.getFrames().size() + macro.getFrameFixes().size());
+            }
+            return success;
+        }
 
         // If not a third-party format, read the file as a Zephyrus macro
-        std::ifstream file(path, std::ios::binary);
-        if (!file.is_open()) {
+        std::vector<uint8_t> data;
+        if (!readWholeFile(path, data, progress)) {
+            return false;
+        }
+
+        BufferReader reader(data.data(), data.size());
+        if (!reader.has(FileHeaderSize)) {
             return false;
         }
 
-        MacroFileHeader header = FileReader::readFileHeader(file);
+        MacroFileHeader header = readFileHeader(reader);
+
+        if (header.magic != 0x525A) {
+            return false;
+        }
+
+        if (header.version == 3) {
+            if (progress) {
+                progress->recordsTotal.store(header.actionCount + uint64_t(header.frameFixCount));
+            }
+            return readChunks(reader, header, data.data(), macro, progress);
+        }
+
+        if (header.version != 2) {
+            return false;
+        }
 
-        if (header.magic != 0x525A || header.version != 2) {
+        // Every fix takes at least one player, which allows rejecting broken counts before allocating
+        if (!reader.has(header.actionCount * size_t(FileActionSize) +
+                        header.frameFixCount * size_t(FileFrameFixSize))) {
             return false;
         }
 
         macro.clearFrames();
+        macro.reserve(header.actionCount, header.frameFixCount);
+        if (progress) {
+            progress->recordsTotal.store(header.actionCount + uint64_t(header.frameFixCount));
+        }
 
         for (uint32_t i = 0; i < header.actionCount; i++) {
-            MacroFileAction action = FileReader::readFileAction(file);
-            macro.addFrame(action.frame, action.isPlayer2(), action.getButton(), action.isButtonDown());
+            if (i % ProgressRecordCount == 0) {
+                if (isCancelled(progress)) return false;
+                addRecords(progress, std::min<uint64_t>(ProgressRecordCount, header.actionCount - i));
+            }
+
+            MacroFileAction action = readFileAction(reader);
+            macro.addFrame(action.frame, action.flags);
         }
 
         for (uint32_t i = 0; i < header.frameFixCount; i++) {
+            if (i % ProgressRecordCount == 0) {
+                if (isCancelled(progress)) return false;
+                addRecords(progress, std::min<uint64_t>(ProgressRecordCount, header.frameFixCount - i));
+            }
+
+            if (!reader.has(FileFrameFixSize)) {
+                return false;
+            }
+
             MacroFileFrameFix frameFix{};
-            frameFix.frame = FileReader::read<uint32_t>(file);
-            frameFix.player1 = FileReader::readPlayerData(file);
-            frameFix.player2Exists = FileReader::read<bool>(file);
+            frameFix.frame = reader.read<uint32_t>();
+            frameFix.player1 = readPlayerData(reader);
+            frameFix.player2Exists = reader.read<uint8_t>() != 0;
             if (frameFix.player2Exists) {
-                frameFix.player2 = FileReader::readPlayerData(file);
+                if (!reader.has(PlayerDataSize)) {
+                    return false;
+                }
+                frameFix.player2 = readPlayerData(reader);
             }
 
             if (frameFix.player2Exists) {
@@ -164,52 +470,101 @@ namespace zephyrus {
         return true;
     }
 
-    void writeToFile(const Macro &macro, const std::filesystem::path &path) {
-        // Deduce file format from file extension
-        std::string extension = path.extension().string();
-        if (extension == ".gdr") // Read GDReplay file
-            return formats::GDR::writeToFile(macro, path);
+    bool readFromFile(const std::filesystem::path &path, Macro &macro, uint32_t startFrame, uint32_t endFrame) {
+        if (readIndexedWindow(path, macro, startFrame, endFrame)) {
+            return true;
+        }
 
-        // If not a third-party format, write the file as a Zephyrus macro
-        std::ofstream file(path, std::ios::binary);
-        if (!file.is_open()) {
-            return;
+        // Formats without an index are read whole, then the window is copied out
+        Macro source(macro.getResource());
+        if (!readFromFile(path, source)) {
+            return false;
         }
 
+        macro.clearFrames();
+        for (const auto &frame : source.getFramesView(startFrame, endFrame)) {
+            macro.addFrame(frame.getFrame(), frame.getFlags());
+        }
+        for (const auto &frameFix : source.getFrameFixesView(startFrame, endFrame)) {
+            if (frameFix.player2Exists()) {
+                macro.addFrameFix(frameFix.getFrame(), frameFix.getPlayer1(), frameFix.getPlayer2());
+            } else {
+                macro.addFrameFix(frameFix.getFrame(), frameFix.getPlayer1());
+            }
+        }
+        return true;
+    }
+
+    bool writeToFile(const Macro &macro, const std::filesystem::path &path, uint8_t version, MacroFileCodec codec) {
+        return FileReader::writeMacroFile(macro, path, version, codec, nullptr);
+    }
+
+    bool FileReader::writeMacroFile(const Macro &macro, const std::filesystem::path &path, uint8_t version,
+                                    MacroFileCodec codec, Progress *progress) {
+        // Deduce file format from file extension
+        if (formats::GDR::isReplayPath(path)) { // Write GDReplay file
+            return !isCancelled(progress) && formats::GDR::writeToFile(macro, path);
+        }
+
+        // If not a third-party format, write the file as a Zephyrus macro, in one of the versions readers support
+        if (version != 2 && version != 3)
+            return false;
+        if (version == 2 && codec != MacroFileCodec::None)
+            return false; // Version 2 has no chunks, so its records cannot be compressed
+        if (version == 3)
+            return writeChunks(macro, path, codec, progress);
+
+        const auto &frames = macro.getFrames();
+        const auto &frameFixes = macro.getFrameFixes();
+        const auto &player1 = frameFixes.getPlayer1Columns();
+        const auto &player2 = frameFixes.getPlayer2Columns();
+        const auto &player2Indices = frameFixes.getPlayer2Indices();
+
         MacroFileHeader header{};
         header.magic = 0x525A;
         header.version = 2;
         header.recordedFPS = 240;
-        header.actionCount = macro.getFrames().size();
-        header.frameFixCount = macro.getFrameFixes().size();
-
-        FileReader::writeFileHeader(file, header);
+        header.actionCount = frames.size();
+        header.frameFixCount = frameFixes.size();
+
+        // Serialize everything into one buffer of the exact size, then write it at once
+        BufferWriter writer(FileHeaderSize +
+                            frames.size() * FileActionSize +
+                            frameFixes.size() * FileFrameFixSize +
+                            player2Indices.size() * PlayerDataSize);
+
+        writeFileHeader(writer, header);
+        if (progress) {
+            progress->recordsTotal.store(frames.size() + uint64_t(frameFixes.size()));
+        }
 
-        for (const auto &frame : macro.getFrames()) {
+        for (const auto &frame : frames) {
             MacroFileAction action{};
             action.frame = frame.getFrame();
-            action.flags = (frame.isSecondPlayer() ? 0b10000000 : 0) |
-                           (frame.isPressed() ? 0b01000000 : 0) |
-                           (static_cast<uint8_t>(frame.getButton()) << 4);
-            FileReader::writeFileAction(file, action);
+            action.flags = frame.getFlags();
+            writeFileAction(writer, action);
         }
 
-        for (const auto &frameFix : macro.getFrameFixes()) {
-            MacroFileFrameFix fix{};
-            fix.frame = frameFix.getFrame();
-            fix.player1 = frameFix.getPlayer1();
-            fix.player2Exists = frameFix.player2Exists();
-            if (fix.player2Exists) {
-                fix.player2 = frameFix.getPlayer2();
+        // Walk the columns directly, with a second cursor over the fixes that have player 2 data
+        size_t player2Position = 0;
+        for (size_t i = 0; i < frameFixes.size(); i++) {
+            if (i % ProgressRecordCount == 0) {
+                if (isCancelled(progress)) return false;
+                addRecords(progress, std::min<uint64_t>(ProgressRecordCount, frameFixes.size() - i));
             }
 
-            FileReader::write(file, fix.frame);
-            FileReader::writePlayerData(file, fix.player1);
-            FileReader::write(file, fix.player2Exists);
-            if (fix.player2Exists) {
-                FileReader::writePlayerData(file, fix.player2);
+            bool player2Exists = player2Position < player2Indices.size() && player2Indices[player2Position] == i;
+
+            writer.write(frameFixes.getFrame(i));
+            writePlayerData(writer, player1.get(i));
+            writer.write<uint8_t>(player2Exists);
+            if (player2Exists) {
+                writePlayerData(writer, player2.get(player2Position++));
             }
         }
+
+        addRecords(progress, frames.size());
+        return writeWholeFile(path, writer.data().data(), writer.data().size(), progress);
     }
 
-}
\ No newline at end of file
+}
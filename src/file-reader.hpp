@@ -0,0 +1,234 @@
+#pragma once
+
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <utility>
+#include <vector>
+
+#include <zephyrus/file-io.hpp>
+
+namespace zephyrus {
+
+    /// @brief Utility namespace for reading files using little endian
+    namespace FileReader {
+        inline bool isBigEndian()
+        {
+            union {
+                uint32_t i;
+                char c[4];
+            } bInt = {0x01020304};
+            return bInt.c[0] == 1;
+        }
+
+        /// @brief Decodes little endian values from a buffer in memory
+        class BufferReader {
+        public:
+            BufferReader(const uint8_t *data, size_t size) : m_data(data), m_size(size) {}
+
+            /// @brief Returns whether the specified number of bytes can still be read
+            [[nodiscard]] bool has(size_t count) const { return m_size - m_position >= count; }
+
+            /// @brief Returns the number of bytes read so far
+            [[nodiscard]] size_t position() const { return m_position; }
+
+            /// @brief Skips the specified number of bytes (check `has` first)
+            void skip(size_t count) { m_position += count; }
+
+            /// @brief Reads a value using little endian (check `has` first)
+            template<typename T>
+            T read() {
+                T value;
+                std::memcpy(&value, m_data + m_position, sizeof(T));
+                m_position += sizeof(T);
+
+                // If the system is big endian, swap the bytes
+                if (isBigEndian()) {
+                    for (size_t i = 0; i < sizeof(T) / 2; i++) {
+                        std::swap(reinterpret_cast<char *>(&value)[i], reinterpret_cast<char *>(&value)[sizeof(T) - i - 1]);
+                    }
+                }
+
+                return value;
+            }
+
+            /// @brief Reads a floating point value as stored by the writer
+            template<typename T>
+            T readFloat() {
+                T value;
+                std::memcpy(&value, m_data + m_position, sizeof(T));
+                m_position += sizeof(T);
+                return value;
+            }
+
+        protected:
+            const uint8_t *m_data;
+            size_t m_size;
+            size_t m_position = 0;
+        };
+
+        constexpr size_t FileHeaderSize = 2 + 1 + 4 + 4 + 4;
+        constexpr size_t FileHeaderV3Size = FileHeaderSize + 4 + 1;
+        constexpr size_t FileActionSize = 4 + 1;
+        constexpr size_t PlayerDataSize = 4 + 4 + 8 + 4;
+        constexpr size_t FileFrameFixSize = 4 + PlayerDataSize + 1; // Without player 2 data
+
+        inline Macro::FrameFix::PlayerData readPlayerData(BufferReader &reader) {
+            Macro::FrameFix::PlayerData data{};
+            data.x = reader.readFloat<float>();
+            data.y = reader.readFloat<float>();
+            data.ySpeed = reader.readFloat<double>();
+            data.rotation = reader.readFloat<float>();
+            return data;
+        }
+
+        inline MacroFileHeader readFileHeader(BufferReader &reader) {
+            MacroFileHeader header{};
+            header.magic = reader.read<uint16_t>();
+            header.version = reader.read<uint8_t>();
+            header.recordedFPS = reader.read<uint32_t>();
+            header.actionCount = reader.read<uint32_t>();
+            header.frameFixCount = reader.read<uint32_t>();
+            if (header.version >= 3 && reader.has(FileHeaderV3Size - FileHeaderSize)) {
+                header.chunkCount = reader.read<uint32_t>();
+                header.codec = reader.read<uint8_t>();
+            }
+            return header;
+        }
+
+        inline MacroFileAction readFileAction(BufferReader &reader) {
+            MacroFileAction action{};
+            action.frame = reader.read<uint32_t>();
+            action.flags = reader.read<uint8_t>();
+            return action;
+        }
+
+        /// @brief Encodes little endian values into a growing buffer in memory
+        class BufferWriter {
+        public:
+            explicit BufferWriter(size_t expectedSize = 0) { m_data.reserve(expectedSize); }
+
+            /// @brief Writes a value using little endian
+            template<typename T>
+            void write(T value) {
+                // If the system is big endian, swap the bytes
+                if (isBigEndian()) {
+                    for (size_t i = 0; i < sizeof(T) / 2; i++) {
+                        std::swap(reinterpret_cast<char *>(&value)[i], reinterpret_cast<char *>(&value)[sizeof(T) - i - 1]);
+                    }
+                }
+                append(&value, sizeof(T));
+            }
+
+            /// @brief Replaces a value that was already written, for sizes that are only known afterwards
+            template<typename T>
+            void overwrite(size_t position, T value) {
+                if (isBigEndian()) {
+                    for (size_t i = 0; i < sizeof(T) / 2; i++) {
+                        std::swap(reinterpret_cast<char *>(&value)[i], reinterpret_cast<char *>(&value)[sizeof(T) - i - 1]);
+                    }
+                }
+                std::memcpy(m_data.data() + position, &value, sizeof(T));
+            }
+
+            /// @brief Writes a floating point value the same way readFloat expects it
+            template<typename T>
+            void writeFloat(T value) { append(&value, sizeof(T)); }
+
+            void append(const void *data, size_t size) {
+                auto bytes = static_cast<const uint8_t *>(data);
+                m_data.insert(m_data.end(), bytes, bytes + size);
+            }
+
+            [[nodiscard]] const std::vector<uint8_t> &data() const { return m_data; }
+
+            [[nodiscard]] std::vector<uint8_t> &data() { return m_data; }
+
+        protected:
+            std::vector<uint8_t> m_data;
+        };
+
+        inline void writePlayerData(BufferWriter &writer, const Macro::FrameFix::PlayerData &data) {
+            writer.writeFloat(data.x);
+            writer.writeFloat(data.y);
+            writer.writeFloat(data.ySpeed);
+            writer.writeFloat(data.rotation);
+        }
+
+        inline void writeFileHeader(BufferWriter &writer, const MacroFileHeader &header) {
+            writer.write(header.magic);
+            writer.write(header.version);
+            writer.write(header.recordedFPS);
+            writer.write(header.actionCount);
+            writer.write(header.frameFixCount);
+            if (header.version >= 3) {
+                writer.write(header.chunkCount);
+                writer.write(header.codec);
+            }
+        }
+
+        inline void writeFileAction(BufferWriter &writer, const MacroFileAction &action) {
+            writer.write(action.frame);
+            writer.write(action.flags);
+        }
+
+        /// @brief Progress of a file operation, updated by the thread doing it and read by the others
+        struct Progress {
+            std::atomic<uint64_t> bytesDone{};
+            std::atomic<uint64_t> bytesTotal{};
+            std::atomic<uint64_t> recordsDone{};
+            std::atomic<uint64_t> recordsTotal{};
+            std::atomic<bool> cancelled{};
+        };
+
+        /// @brief Number of bytes read or written between two progress updates
+        constexpr size_t ProgressBlockSize = 1024 * 1024;
+
+        /// @brief Number of records decoded or encoded between two progress updates
+        constexpr size_t ProgressRecordCount = 4096;
+
+        /// @brief Returns whether the operation that reports to the progress was cancelled
+        inline bool isCancelled(const Progress *progress) {
+            return progress && progress->cancelled.load(std::memory_order_relaxed);
+        }
+
+        /// @brief Adds processed records to the progress, if there is one
+        inline void addRecords(Progress *progress, uint64_t count) {
+            if (progress) progress->recordsDone.fetch_add(count, std::memory_order_relaxed);
+        }
+
+        /// @brief Reads a whole file into memory, with a single read unless progress is reported
+        bool readWholeFile(const std::filesystem::path &path, std::vector<uint8_t> &data, Progress *progress = nullptr);
+
+        /// @brief Reads a range of bytes of an open file
+        bool readFileRange(std::ifstream &file, uint64_t offset, size_t size, std::vector<uint8_t> &data);
+
+        /// @brief Returns the temporary file that a write to the specified path goes through
+        std::filesystem::path getTemporaryPath(const std::filesystem::path &path);
+
+        /// @brief Flushes a written file to the disk (fsync, FlushFileBuffers on Windows)
+        bool syncFile(const std::filesystem::path &path);
+
+        /// @brief Syncs a fully written temporary file and renames it over the destination
+        /// @note The temporary file is removed if this fails, the destination is left untouched
+        bool commitTemporaryFile(const std::filesystem::path &temporaryPath, const std::filesystem::path &path);
+
+        /// @brief Writes a whole file with a single write, going through a temporary file that is renamed over
+        /// the destination, so that a crash while saving never leaves a partially written file behind
+        /// @note The temporary file is synced to the disk before the rename. A cancelled write removes the
+        /// temporary file and leaves the destination untouched
+        bool writeWholeFile(const std::filesystem::path &path, const uint8_t *data, size_t size,
+                            Progress *progress = nullptr);
+
+        /// @brief Reads a macro in any supported format, reporting to the progress (readFromFile without progress)
+        /// @return False if the file could not be read or the operation was cancelled
+        bool readMacroFile(const std::filesystem::path &path, Macro &macro, Progress *progress);
+
+        /// @brief Writes a macro in the format of the extension, reporting to the progress (writeToFile without progress)
+        /// @return False if the file could not be written or the operation was cancelled
+        bool writeMacroFile(const Macro &macro, const std::filesystem::path &path, uint8_t version,
+                            MacroFileCodec codec, Progress *progress);
+    }
+
+}
@@ -1,7 +1,13 @@
 #include <zephyrus/formats/gdreplay.hpp>
 
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
 #include <fstream>
+#include <string_view>
 #include "../../thirdparty/json.hpp"
+#include "../file-reader.hpp"
 
 #include <iostream>
 
@@ -13,134 +19,1067 @@ namespace zephyrus::formats::GDR {
         MegaHack
     };
 
-    bool readFromFile(const std::filesystem::path &path, Macro &macro) {
-        std::ifstream file(path, std::ios::binary);
-        if (!file.is_open()) {
-            return false;
-        }
+    enum class GDREncoding {
+        Unknown,
+        JSON,
+        MessagePack
+    };
 
-        std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
-        nlohmann::json json;
+    namespace {
+        /// @brief Detects the encoding of a GDR file from its first bytes, the root of a replay is always a map
+        GDREncoding detectEncoding(const std::vector<uint8_t> &data) {
+            size_t position = 0;
 
-        // GDR can be in either JSON or MessagePack format
-        // We'll try to parse it as JSON first
-        json = nlohmann::json::parse(data, nullptr, false);
-        if (json.is_discarded()) {
-            // If it fails, try to parse it as MessagePack
-            json = nlohmann::json::from_msgpack(data, true, false);
-            if (json.is_discarded()) {
-                return false;
+            // JSON can start with a UTF-8 byte order mark and whitespace
+            if (data.size() >= 3 && data[0] == 0xEF && data[1] == 0xBB && data[2] == 0xBF) {
+                position = 3;
+            }
+            while (position < data.size() &&
+                   (data[position] == ' ' || data[position] == '\t' || data[position] == '\n' || data[position] == '\r')) {
+                position++;
+            }
+            if (position < data.size() && data[position] == '{') {
+                return GDREncoding::JSON;
             }
+
+            // MessagePack maps are fixmap (0x80 - 0x8F), map 16 (0xDE) or map 32 (0xDF)
+            if (!data.empty() && ((data[0] & 0xF0) == 0x80 || data[0] == 0xDE || data[0] == 0xDF)) {
+                return GDREncoding::MessagePack;
+            }
+
+            return GDREncoding::Unknown;
         }
+    }
 
-        // Start parsing the JSON
-        try {
-            GDRFormat format = GDRFormat::Unknown;
+    namespace {
+        /// @brief A scalar value of an input, kept until the input is complete
+        struct Value {
+            enum class Type : uint8_t {
+                Missing,
+                Boolean,
+                Number,
+                Null,
+                Other // Strings and containers, which no field accepts
+            };
 
-            // Check whether it's MegaOverlay or MegaHack format (or neither)
-            // This is important because there are differences in the format
-            auto botName = json["bot"]["name"].get<std::string>();
-            if (botName == "Macrobot") {
-                format = GDRFormat::MegaOverlay;
-            } else if (botName == "MH_REPLAY" || botName == "Zephyrus") {
-                format = GDRFormat::MegaHack; // This bot uses the same format as MegaHack for compatibility
+            Type type = Type::Missing;
+            bool boolean{};
+            double number{};
+
+            void set(Type valueType, bool booleanValue, double numberValue) {
+                type = valueType;
+                boolean = booleanValue;
+                number = numberValue;
             }
 
-            // Parse the actions
-            auto inputs = json["inputs"];
-            for (auto &input : inputs) {
-                auto is2player = input["2p"].get<bool>();
-                auto button = input["btn"].get<uint8_t>();
-                auto isDown = input["down"].get<bool>();
-                auto frame = input["frame"].get<uint32_t>();
+            [[nodiscard]] bool isBoolean() const { return type == Type::Boolean; }
+
+            /// @brief Numbers can be read from booleans too, like with nlohmann::json::get
+            [[nodiscard]] bool isNumber() const { return type == Type::Number || type == Type::Boolean; }
 
-                macro.addFrame(frame, is2player, static_cast<PlayerButton>(button), isDown);
+            /// @brief Converts the number to an unsigned integer, wrapping around like nlohmann::json::get
+            template<typename T>
+            [[nodiscard]] T toUnsigned() const {
+                // Values outside of the range of int64_t are clamped to stay defined
+                double clamped = std::max(std::min(number, 9.2e18), -9.2e18);
+                return static_cast<T>(static_cast<int64_t>(clamped));
+            }
+        };
+
+        /// @brief The fields of an input that matter for either of the frame fix formats
+        struct Input {
+            Value player2, button, down, frame;
+
+            // MegaHack frame fix, present if the input has "mhr_meta"
+            bool hasMeta = false;
+            Value x, y, yVelocity;
+
+            // MegaOverlay frame fix, present if the input has "correction"
+            bool hasCorrection = false;
+            Value correctionPlayer2, correctionFrame, correctionX, correctionY, correctionYVelocity, correctionRotation;
+
+            /// @brief Returns the field that receives the value of a key of the input object, if any
+            /// @note "mhr_meta" and "correction" are only recorded as present, their values are not fields
+            Value *findField(std::string_view key) {
+                if (key == "2p") return &player2;
+                if (key == "btn") return &button;
+                if (key == "down") return &down;
+                if (key == "frame") return &frame;
+                if (key == "mhr_x") return &x;
+                if (key == "mhr_y") return &y;
+                if (key == "mhr_yvel") return &yVelocity;
+                if (key == "mhr_meta") hasMeta = true;
+                else if (key == "correction") hasCorrection = true;
+                return nullptr;
+            }
+
+            /// @brief Returns the field that receives the value of a key of the correction object, if any
+            Value *findCorrectionField(std::string_view key) {
+                if (key == "player2") return &correctionPlayer2;
+                if (key == "frame") return &correctionFrame;
+                if (key == "xPos") return &correctionX;
+                if (key == "yPos") return &correctionY;
+                if (key == "yVel") return &correctionYVelocity;
+                if (key == "rotation") return &correctionRotation;
+                return nullptr;
+            }
+        };
+
+        /// @brief Adds the inputs found by a parser to the macro, with the frame fixes of the bot that recorded them
+        /// @note If the bot name comes after the inputs, the inputs are kept until it is found.
+        class ReplayBuilder {
+        public:
+            explicit ReplayBuilder(Macro &macro) : m_macro(macro) {}
+
+            void setBotName(std::string_view name) {
+                m_hasBotName = true;
+
+                // Check whether it's MegaOverlay or MegaHack format (or neither)
+                // This is important because there are differences in the format
+                if (name == "Macrobot") {
+                    m_format = GDRFormat::MegaOverlay;
+                } else if (name == "MH_REPLAY" || name == "Zephyrus") {
+                    m_format = GDRFormat::MegaHack; // This bot uses the same format as MegaHack for compatibility
+                } else {
+                    m_format = GDRFormat::Unknown;
+                }
+            }
+
+            /// @brief Adds a complete input, or keeps it if the bot name was not found yet
+            /// @return False if the input is malformed
+            bool add(const Input &input) {
+                if (!m_hasBotName) {
+                    m_pending.push_back(input);
+                    return true;
+                }
+                return addInput(input);
+            }
+
+            /// @brief Adds the inputs that were kept for the bot name, once the parse is done
+            /// @return False if the replay has no bot name or an input is malformed
+            bool finish() {
+                if (!m_hasBotName) {
+                    return false;
+                }
+                for (const auto &input : m_pending) {
+                    if (!addInput(input)) return false;
+                }
+                m_pending.clear();
+                return true;
+            }
+
+        protected:
+            /// @brief Adds the action of an input and its frame fix, if it has one in the format of the replay
+            bool addInput(const Input &input) {
+                if (!input.player2.isBoolean() || !input.button.isNumber() || !input.down.isBoolean() ||
+                    !input.frame.isNumber()) {
+                    return false;
+                }
+
+                auto frame = input.frame.toUnsigned<uint32_t>();
+                auto button = input.button.toUnsigned<uint8_t>();
+                m_macro.addFrame(frame, input.player2.boolean, static_cast<PlayerButton>(button), input.down.boolean);
 
                 // Parse the frame fix
-                if (format == GDRFormat::MegaHack) {
-                    if (!input.contains("mhr_meta")) continue;
+                if (m_format == GDRFormat::MegaHack) {
+                    if (!input.hasMeta) return true;
+                    if (!input.x.isNumber() || !input.y.isNumber() || !input.yVelocity.isNumber()) return false;
+
+                    m_macro.addFrameFix(frame, {float(input.x.number), float(input.y.number), input.yVelocity.number, 0});
+                } else if (m_format == GDRFormat::MegaOverlay) {
+                    if (!input.hasCorrection) return true;
+                    if (!input.correctionPlayer2.isBoolean()) return false;
+                    if (input.correctionPlayer2.boolean) return true;
+                    if (!input.correctionFrame.isNumber() || !input.correctionX.isNumber() ||
+                        !input.correctionY.isNumber() || !input.correctionYVelocity.isNumber() ||
+                        !input.correctionRotation.isNumber()) {
+                        return false;
+                    }
+
+                    m_macro.addFrameFix(input.correctionFrame.toUnsigned<uint32_t>(),
+                                        {float(input.correctionX.number), float(input.correctionY.number),
+                                         input.correctionYVelocity.number, float(input.correctionRotation.number)});
+                }
+                return true;
+            }
+
+            Macro &m_macro;
+            bool m_hasBotName = false;
+            GDRFormat m_format = GDRFormat::Unknown;
+            std::vector<Input> m_pending; // Inputs found before the bot name
+        };
+
+        /// @brief Receives the events of nlohmann::json::sax_parse and passes every input to the builder as soon as
+        /// it is complete, so that no document is built in memory
+        class ReplayHandler {
+        public:
+            using Json = nlohmann::json;
 
-                    auto posX = input["mhr_x"].get<float>();
-                    auto posY = input["mhr_y"].get<float>();
-                    auto yVel = input["mhr_yvel"].get<double>();
+            explicit ReplayHandler(ReplayBuilder &builder) : m_builder(builder) {}
 
-                    macro.addFrameFix(frame, {posX, posY, yVel, 0});
+            bool null() { return setValue(Value::Type::Null, false, 0); }
+
+            bool boolean(bool value) { return setValue(Value::Type::Boolean, value, value); }
+
+            bool number_integer(Json::number_integer_t value) { return setValue(Value::Type::Number, false, double(value)); }
+
+            bool number_unsigned(Json::number_unsigned_t value) { return setValue(Value::Type::Number, false, double(value)); }
+
+            bool number_float(Json::number_float_t value, const Json::string_t &) {
+                return setValue(Value::Type::Number, false, value);
+            }
+
+            bool string(Json::string_t &value) {
+                if (m_depth == 2 && m_section == Section::Bot && m_botNameKey) {
+                    m_builder.setBotName(value);
+                    return true;
                 }
-                else if (format == GDRFormat::MegaOverlay) {
-                    if (!input.contains("correction")) continue;
-                    auto correction = input["correction"];
-                    if (correction["player2"].get<bool>()) continue;
+                return setValue(Value::Type::Other, false, 0);
+            }
 
-                    frame = correction["frame"].get<uint32_t>();
-                    auto posX = correction["xPos"].get<float>();
-                    auto posY = correction["yPos"].get<float>();
-                    auto yVel = correction["yVel"].get<double>();
-                    auto rotation = correction["rotation"].get<float>();
+            bool binary(Json::binary_t &) { return setValue(Value::Type::Other, false, 0); }
 
-                    macro.addFrameFix(frame, {posX, posY, yVel, rotation});
+            bool start_object(std::size_t) {
+                startContainer();
+                if (m_depth == 2 && m_section == Section::Inputs) {
+                    m_input = Input();
+                    m_inInput = true;
+                } else if (m_depth == 3 && m_inInput && m_correctionKey) {
+                    m_inCorrection = true;
                 }
+                m_depth++;
+                return true;
+            }
+
+            bool end_object() {
+                m_depth--;
+                if (m_depth == 3 && m_inCorrection) {
+                    m_inCorrection = false;
+                } else if (m_depth == 2 && m_inInput) {
+                    m_inInput = false;
+                    return m_builder.add(m_input);
+                }
+                return true;
+            }
+
+            bool start_array(std::size_t) {
+                // The replay and its inputs are objects, anything else makes it malformed
+                if (m_depth == 0 || (m_depth == 2 && m_section == Section::Inputs)) return false;
+
+                startContainer();
+                m_depth++;
+                return true;
+            }
+
+            bool end_array() {
+                m_depth--;
+                return true;
             }
 
-        } catch (const nlohmann::json::exception &e) {
+            bool key(Json::string_t &key) {
+                m_target = nullptr;
+                m_botNameKey = false;
+                m_correctionKey = false;
+
+                if (m_depth == 1) {
+                    if (key == "bot") {
+                        m_section = Section::Bot;
+                    } else if (key == "inputs") {
+                        m_section = Section::Inputs;
+                    } else {
+                        m_section = Section::Other;
+                    }
+                } else if (m_depth == 2 && m_section == Section::Bot) {
+                    m_botNameKey = key == "name";
+                } else if (m_depth == 3 && m_inInput) {
+                    m_target = m_input.findField(key);
+                    m_correctionKey = key == "correction";
+                } else if (m_depth == 4 && m_inCorrection) {
+                    m_target = m_input.findCorrectionField(key);
+                }
+                return true;
+            }
+
+            bool parse_error(std::size_t, const std::string &, const nlohmann::detail::exception &) { return false; }
+
+        protected:
+            /// @brief Value of the root object the parser is in
+            enum class Section {
+                Other,
+                Bot,
+                Inputs
+            };
+
+            /// @brief Handles a scalar value
+            bool setValue(Value::Type type, bool boolean, double number) {
+                // The "inputs" list can be null (no inputs), any other value in it would have to be an object
+                if (m_depth == 1 && m_section == Section::Inputs && type != Value::Type::Null) return false;
+                if (m_depth == 2 && m_section == Section::Inputs) return false;
+
+                if (m_target) {
+                    m_target->set(type, boolean, number);
+                    m_target = nullptr;
+                }
+                return true;
+            }
+
+            /// @brief Handles the start of an object or an array as a value
+            void startContainer() {
+                if (m_target) {
+                    m_target->type = Value::Type::Other;
+                    m_target = nullptr;
+                }
+            }
+
+            ReplayBuilder &m_builder;
+            size_t m_depth{}; // Number of open objects and arrays
+            Section m_section = Section::Other;
+            Value *m_target = nullptr; // Field that receives the next value
+            bool m_botNameKey = false; // Whether the next value is the bot name
+            bool m_correctionKey = false; // Whether the next value is the correction of the input
+            bool m_inInput = false;
+            bool m_inCorrection = false;
+            Input m_input;
+        };
+
+        /// @brief Decodes a MessagePack replay straight into the builder
+        /// @note Only the keys of the GDR schema are decoded, any other value is skipped without being decoded.
+        /// Accepts and rejects the same replays as nlohmann::json::sax_parse with ReplayHandler.
+        class MessagePackReader {
+        public:
+            MessagePackReader(const uint8_t *data, size_t size, ReplayBuilder &builder) :
+                    m_data(data), m_end(data + size), m_builder(builder) {}
+
+            /// @brief Reads the whole replay
+            /// @return False if the data is not a well-formed replay
+            bool read() {
+                size_t count;
+                if (!readMapHeader(count)) {
+                    // Anything but a map cannot hold a bot name, so only check that it is a single valid value
+                    return skipValue() && m_data == m_end;
+                }
+
+                for (size_t i = 0; i < count; i++) {
+                    std::string_view key;
+                    if (!readString(key)) return false;
+
+                    bool success;
+                    if (key == "bot") {
+                        success = readBot();
+                    } else if (key == "inputs") {
+                        success = readInputs();
+                    } else {
+                        success = skipValue();
+                    }
+                    if (!success) return false;
+                }
+                return m_data == m_end;
+            }
+
+        protected:
+            /// @brief Reads a big endian integer (check `has` first)
+            template<typename T>
+            T readBigEndian() {
+                T value{};
+                for (size_t i = 0; i < sizeof(T); i++) {
+                    value = static_cast<T>(value << 8 | m_data[i]);
+                }
+                m_data += sizeof(T);
+                return value;
+            }
+
+            [[nodiscard]] bool has(size_t count) const { return size_t(m_end - m_data) >= count; }
+
+            /// @brief Reads the header of a map, leaving the data untouched if the next value is not a map
+            bool readMapHeader(size_t &count) {
+                if (!has(1)) return false;
+                uint8_t type = *m_data;
+                if ((type & 0xF0) == 0x80) {
+                    m_data++;
+                    count = type & 0x0F;
+                } else if (type == 0xDE && has(3)) {
+                    m_data++;
+                    count = readBigEndian<uint16_t>();
+                } else if (type == 0xDF && has(5)) {
+                    m_data++;
+                    count = readBigEndian<uint32_t>();
+                } else {
+                    return false;
+                }
+                return true;
+            }
+
+            /// @brief Reads a string, keys of maps have to be strings
+            bool readString(std::string_view &value) {
+                if (!has(1)) return false;
+                uint8_t type = *m_data++;
+                size_t length;
+                if ((type & 0xE0) == 0xA0) {
+                    length = type & 0x1F;
+                } else if (type == 0xD9 && has(1)) {
+                    length = readBigEndian<uint8_t>();
+                } else if (type == 0xDA && has(2)) {
+                    length = readBigEndian<uint16_t>();
+                } else if (type == 0xDB && has(4)) {
+                    length = readBigEndian<uint32_t>();
+                } else {
+                    return false;
+                }
+
+                if (!has(length)) return false;
+                value = std::string_view(reinterpret_cast<const char *>(m_data), length);
+                m_data += length;
+                return true;
+            }
+
+            /// @brief Reads a value into a field, strings, binary data and containers are skipped
+            bool readValue(Value &value) {
+                if (!has(1)) return false;
+                uint8_t type = *m_data;
+
+                if (type <= 0x7F) { // Positive fixint
+                    m_data++;
+                    value.set(Value::Type::Number, false, type);
+                    return true;
+                }
+                if (type >= 0xE0) { // Negative fixint
+                    m_data++;
+                    value.set(Value::Type::Number, false, int8_t(type));
+                    return true;
+                }
+
+                switch (type) {
+                    case 0xC0: m_data++; value.set(Value::Type::Null, false, 0); return true;
+                    case 0xC2: m_data++; value.set(Value::Type::Boolean, false, 0); return true;
+                    case 0xC3: m_data++; value.set(Value::Type::Boolean, true, 1); return true;
+                    case 0xCA: return readNumber<uint32_t>(value, [](uint32_t bits) { return double(fromBits<float>(bits)); });
+                    case 0xCB: return readNumber<uint64_t>(value, [](uint64_t bits) { return fromBits<double>(bits); });
+                    case 0xCC: return readNumber<uint8_t>(value, [](uint8_t number) { return double(number); });
+                    case 0xCD: return readNumber<uint16_t>(value, [](uint16_t number) { return double(number); });
+                    case 0xCE: return readNumber<uint32_t>(value, [](uint32_t number) { return double(number); });
+                    case 0xCF: return readNumber<uint64_t>(value, [](uint64_t number) { return double(number); });
+                    case 0xD0: return readNumber<uint8_t>(value, [](uint8_t number) { return double(int8_t(number)); });
+                    case 0xD1: return readNumber<uint16_t>(value, [](uint16_t number) { return double(int16_t(number)); });
+                    case 0xD2: return readNumber<uint32_t>(value, [](uint32_t number) { return double(int32_t(number)); });
+                    case 0xD3: return readNumber<uint64_t>(value, [](uint64_t number) { return double(int64_t(number)); });
+                    default:
+                        value.set(Value::Type::Other, false, 0);
+                        return skipValue();
+                }
+            }
+
+            template<typename T, typename Convert>
+            bool readNumber(Value &value, Convert convert) {
+                if (!has(1 + sizeof(T))) return false;
+                m_data++;
+                value.set(Value::Type::Number, false, convert(readBigEndian<T>()));
+                return true;
+            }
+
+            template<typename T>
+            static T fromBits(std::conditional_t<sizeof(T) == 8, uint64_t, uint32_t> bits) {
+                T value;
+                std::memcpy(&value, &bits, sizeof(T));
+                return value;
+            }
+
+            /// @brief Skips any value without decoding it, nested values included
+            bool skipValue() {
+                // Values left to skip, counted instead of recursing so that deep nesting cannot overflow the stack
+                uint64_t remaining = 1;
+                while (remaining > 0) {
+                    remaining--;
+                    if (!has(1)) return false;
+                    uint8_t type = *m_data++;
+
+                    size_t size = 0; // Bytes that follow the type and the length
+                    uint64_t children = 0; // Values that follow them
+                    if (type <= 0x7F || type >= 0xE0 || type == 0xC0 || type == 0xC2 || type == 0xC3) {
+                        // Single byte values
+                    } else if ((type & 0xF0) == 0x80) {
+                        children = uint64_t(type & 0x0F) * 2;
+                    } else if ((type & 0xF0) == 0x90) {
+                        children = type & 0x0F;
+                    } else if ((type & 0xE0) == 0xA0) {
+                        size = type & 0x1F;
+                    } else {
+                        switch (type) {
+                            case 0xC4: case 0xD9: if (!has(1)) return false; size = readBigEndian<uint8_t>(); break;
+                            case 0xC5: case 0xDA: if (!has(2)) return false; size = readBigEndian<uint16_t>(); break;
+                            case 0xC6: case 0xDB: if (!has(4)) return false; size = readBigEndian<uint32_t>(); break;
+                            case 0xC7: if (!has(1)) return false; size = readBigEndian<uint8_t>() + size_t(1); break;
+                            case 0xC8: if (!has(2)) return false; size = readBigEndian<uint16_t>() + size_t(1); break;
+                            case 0xC9: if (!has(4)) return false; size = readBigEndian<uint32_t>() + size_t(1); break;
+                            case 0xCA: case 0xCE: case 0xD2: size = 4; break;
+                            case 0xCB: case 0xCF: case 0xD3: size = 8; break;
+                            case 0xCC: case 0xD0: size = 1; break;
+                            case 0xCD: case 0xD1: size = 2; break;
+                            case 0xD4: size = 2; break; // fixext 1, with its type
+                            case 0xD5: size = 3; break;
+                            case 0xD6: size = 5; break;
+                            case 0xD7: size = 9; break;
+                            case 0xD8: size = 17; break;
+                            case 0xDC: if (!has(2)) return false; children = readBigEndian<uint16_t>(); break;
+                            case 0xDD: if (!has(4)) return false; children = readBigEndian<uint32_t>(); break;
+                            case 0xDE: if (!has(2)) return false; children = uint64_t(readBigEndian<uint16_t>()) * 2; break;
+                            case 0xDF: if (!has(4)) return false; children = uint64_t(readBigEndian<uint32_t>()) * 2; break;
+                            default: return false; // 0xC1 is never used
+                        }
+                    }
+
+                    if (!has(size)) return false;
+                    m_data += size;
+
+                    // Every value takes at least a byte, which rejects broken counts right away
+                    remaining += children;
+                    if (remaining > size_t(m_end - m_data)) return false;
+                }
+                return true;
+            }
+
+            bool readBot() {
+                size_t count;
+                if (!readMapHeader(count)) return skipValue();
+
+                for (size_t i = 0; i < count; i++) {
+                    std::string_view key, name;
+                    if (!readString(key)) return false;
+                    if (key == "name" && has(1) && isString(*m_data)) {
+                        if (!readString(name)) return false;
+                        m_builder.setBotName(name);
+                    } else if (!skipValue()) {
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+            static bool isString(uint8_t type) {
+                return (type & 0xE0) == 0xA0 || type == 0xD9 || type == 0xDA || type == 0xDB;
+            }
+
+            bool readInputs() {
+                if (!has(1)) return false;
+                uint8_t type = *m_data;
+
+                // No inputs
+                if (type == 0xC0) {
+                    m_data++;
+                    return true;
+                }
+
+                // Inputs are usually in an array, the values of a map are read the same way
+                size_t count;
+                bool isMap = readMapHeader(count);
+                if (!isMap) {
+                    if ((type & 0xF0) == 0x90) {
+                        count = type & 0x0F;
+                        m_data++;
+                    } else if (type == 0xDC && has(3)) {
+                        m_data++;
+                        count = readBigEndian<uint16_t>();
+                    } else if (type == 0xDD && has(5)) {
+                        m_data++;
+                        count = readBigEndian<uint32_t>();
+                    } else {
+                        return false;
+                    }
+                }
+
+                for (size_t i = 0; i < count; i++) {
+                    std::string_view key;
+                    if (isMap && !readString(key)) return false;
+                    if (!readInput()) return false;
+                }
+                return true;
+            }
+
+            bool readInput() {
+                size_t count;
+                if (!readMapHeader(count)) return false;
+
+                Input input;
+                for (size_t i = 0; i < count; i++) {
+                    std::string_view key;
+                    if (!readString(key)) return false;
+
+                    if (key == "correction") {
+                        input.hasCorrection = true;
+                        if (!readCorrection(input)) return false;
+                    } else if (Value *field = input.findField(key)) {
+                        if (!readValue(*field)) return false;
+                    } else if (!skipValue()) {
+                        return false;
+                    }
+                }
+                return m_builder.add(input);
+            }
+
+            bool readCorrection(Input &input) {
+                size_t count;
+                if (!readMapHeader(count)) return skipValue();
+
+                for (size_t i = 0; i < count; i++) {
+                    std::string_view key;
+                    if (!readString(key)) return false;
+
+                    if (Value *field = input.findCorrectionField(key)) {
+                        if (!readValue(*field)) return false;
+                    } else if (!skipValue()) {
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+            const uint8_t *m_data;
+            const uint8_t *m_end;
+            ReplayBuilder &m_builder;
+        };
+    }
+
+    bool readFromFile(const std::filesystem::path &path, Macro &macro) {
+        std::vector<uint8_t> data;
+        if (!FileReader::readWholeFile(path, data)) {
             return false;
         }
 
-        return true;
+        // GDR can be in either JSON or MessagePack format, inputs are added while parsing,
+        // without building the document in memory
+        ReplayBuilder builder(macro);
+        switch (detectEncoding(data)) {
+            case GDREncoding::JSON: {
+                ReplayHandler handler(builder);
+                return nlohmann::json::sax_parse(data, &handler) && builder.finish();
+            }
+            case GDREncoding::MessagePack: {
+                MessagePackReader reader(data.data(), data.size(), builder);
+                return reader.read() && builder.finish();
+            }
+            case GDREncoding::Unknown:
+                break;
+        }
+        return false;
     }
 
-    void writeToFile(const Macro &macro, const std::filesystem::path &path) {
-        // Set metadata
-        nlohmann::json json;
-        json["author"] = "";
-        json["bot"] = {
-            {"name", "Zephyrus"},
-            {"version", "2"}
+    namespace {
+        /// @brief Collects output in a buffer that goes to the stream whenever it fills up
+        class BufferedOutput {
+        public:
+            /// @brief Output is collected up to this size before going to the stream
+            static constexpr size_t BufferSize = 64 * 1024;
+
+            explicit BufferedOutput(std::ostream &stream) : m_stream(stream) {
+                m_buffer.reserve(BufferSize + 256);
+            }
+
+            /// @brief Writes the rest of the buffer to the stream
+            /// @return Whether everything was written successfully
+            bool finish() {
+                flush();
+                m_stream.flush();
+                return m_stream.good();
+            }
+
+        protected:
+            /// @brief Flushes the buffer if it is full, called before each value
+            void reserveValue() {
+                if (m_buffer.size() >= BufferSize) flush();
+            }
+
+            void flush() {
+                m_stream.write(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()));
+                m_buffer.clear();
+            }
+
+            std::ostream &m_stream;
+            std::string m_buffer;
+        };
+
+        /// @brief Writes JSON to a stream as it is produced, instead of building the document first
+        /// @note The counts passed to beginObject and beginArray are only needed by MessagePackWriter
+        class JsonWriter : public BufferedOutput {
+        public:
+            /// @param indent The number of spaces per nesting level, or -1 for compact output, like nlohmann::json::dump
+            JsonWriter(std::ostream &stream, int indent) : BufferedOutput(stream), m_indent(indent) {}
+
+            void beginObject(size_t) { beginContainer('{'); }
+
+            void endObject() { endContainer('}'); }
+
+            void beginArray(size_t) { beginContainer('['); }
+
+            void endArray() { endContainer(']'); }
+
+            /// @brief Writes the key of the next value in an object
+            void key(std::string_view key) {
+                beginValue();
+                writeEscaped(key);
+                m_buffer += ':';
+                if (m_indent >= 0) m_buffer += ' ';
+                m_afterKey = true;
+            }
+
+            void writeBool(bool value) {
+                beginValue();
+                m_buffer += value ? "true" : "false";
+            }
+
+            void writeInteger(int64_t value) {
+                beginValue();
+                writeChars(value);
+            }
+
+            void writeUnsigned(uint64_t value) {
+                beginValue();
+                writeChars(value);
+            }
+
+            /// @brief Writes the shortest representation that reads back to the same value, like nlohmann::json
+            void writeFloat(double value) {
+                beginValue();
+                if (!std::isfinite(value)) {
+                    m_buffer += "null";
+                    return;
+                }
+
+                char buffer[64];
+                char *end = nlohmann::detail::to_chars(buffer, buffer + sizeof(buffer), value);
+                m_buffer.append(buffer, end);
+            }
+
+            void writeString(std::string_view value) {
+                beginValue();
+                writeEscaped(value);
+            }
+
+        protected:
+            void beginContainer(char open) {
+                beginValue();
+                m_buffer += open;
+                m_empty.push_back(true);
+            }
+
+            void endContainer(char close) {
+                bool empty = m_empty.back();
+                m_empty.pop_back();
+                if (!empty) newLine();
+                m_buffer += close;
+            }
+
+            /// @brief Writes the separator between the previous value of the container and the next one
+            void beginValue() {
+                reserveValue();
+                if (m_afterKey) {
+                    m_afterKey = false;
+                    return;
+                }
+                if (m_empty.empty()) return;
+
+                if (!m_empty.back()) m_buffer += ',';
+                m_empty.back() = false;
+                newLine();
+            }
+
+            void newLine() {
+                if (m_indent < 0) return;
+                m_buffer += '\n';
+                m_buffer.append(m_empty.size() * m_indent, ' ');
+            }
+
+            template<typename T>
+            void writeChars(T value) {
+                char buffer[24];
+                auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+                m_buffer.append(buffer, result.ptr);
+            }
+
+            void writeEscaped(std::string_view value) {
+                static constexpr char HexDigits[] = "0123456789abcdef";
+
+                m_buffer += '"';
+                for (char c : value) {
+                    switch (c) {
+                        case '"': m_buffer += "\\\""; break;
+                        case '\\': m_buffer += "\\\\"; break;
+                        case '\b': m_buffer += "\\b"; break;
+                        case '\f': m_buffer += "\\f"; break;
+                        case '\n': m_buffer += "\\n"; break;
+                        case '\r': m_buffer += "\\r"; break;
+                        case '\t': m_buffer += "\\t"; break;
+                        default:
+                            if (static_cast<uint8_t>(c) < 0x20) {
+                                m_buffer += "\\u00";
+                                m_buffer += HexDigits[c >> 4];
+                                m_buffer += HexDigits[c & 15];
+                            } else {
+                                m_buffer += c;
+                            }
+                    }
+                }
+                m_buffer += '"';
+            }
+
+            int m_indent; // Negative for compact output
+            std::vector<bool> m_empty; // Whether each open container is still empty
+            bool m_afterKey = false;
         };
-        json["coins"] = 0;
-        json["description"] = "";
-        json["duration"] = macro.getFrames().back().getFrame();
-        json["gameVersion"] = 2.204;
-        json["ldm"] = false;
-        json["level"] = {
-            {"id", 0},
-            {"name", ""}
+
+        /// @brief Writes MessagePack to a stream as it is produced, with the smallest encoding of each value
+        /// like nlohmann::json::to_msgpack
+        class MessagePackWriter : public BufferedOutput {
+        public:
+            explicit MessagePackWriter(std::ostream &stream) : BufferedOutput(stream) {}
+
+            /// @param count The number of key and value pairs that follow
+            void beginObject(size_t count) {
+                reserveValue();
+                writeHeader(count, 0x80, 0xDE);
+            }
+
+            void endObject() {}
+
+            /// @param count The number of values that follow
+            void beginArray(size_t count) {
+                reserveValue();
+                writeHeader(count, 0x90, 0xDC);
+            }
+
+            void endArray() {}
+
+            void key(std::string_view key) { writeString(key); }
+
+            void writeBool(bool value) {
+                reserveValue();
+                m_buffer += char(value ? 0xC3 : 0xC2);
+            }
+
+            void writeInteger(int64_t value) {
+                if (value >= 0) {
+                    writeUnsigned(uint64_t(value));
+                    return;
+                }
+
+                reserveValue();
+                if (value >= -32) {
+                    m_buffer += char(value); // Negative fixint
+                } else if (value >= INT8_MIN) {
+                    writeNumber<uint8_t>(0xD0, uint8_t(value));
+                } else if (value >= INT16_MIN) {
+                    writeNumber<uint16_t>(0xD1, uint16_t(value));
+                } else if (value >= INT32_MIN) {
+                    writeNumber<uint32_t>(0xD2, uint32_t(value));
+                } else {
+                    writeNumber<uint64_t>(0xD3, uint64_t(value));
+                }
+            }
+
+            void writeUnsigned(uint64_t value) {
+                reserveValue();
+                if (value < 128) {
+                    m_buffer += char(value); // Positive fixint
+                } else if (value <= UINT8_MAX) {
+                    writeNumber<uint8_t>(0xCC, uint8_t(value));
+                } else if (value <= UINT16_MAX) {
+                    writeNumber<uint16_t>(0xCD, uint16_t(value));
+                } else if (value <= UINT32_MAX) {
+                    writeNumber<uint32_t>(0xCE, uint32_t(value));
+                } else {
+                    writeNumber<uint64_t>(0xCF, value);
+                }
+            }
+
+            /// @brief Writes a 32-bit float when it holds the value exactly, a 64-bit float otherwise
+            void writeFloat(double value) {
+                reserveValue();
+                auto single = static_cast<float>(value);
+                if (static_cast<double>(single) == value) {
+                    uint32_t bits;
+                    std::memcpy(&bits, &single, sizeof(bits));
+                    writeNumber<uint32_t>(0xCA, bits);
+                } else {
+                    uint64_t bits;
+                    std::memcpy(&bits, &value, sizeof(bits));
+                    writeNumber<uint64_t>(0xCB, bits);
+                }
+            }
+
+            void writeString(std::string_view value) {
+                reserveValue();
+                if (value.size() < 32) {
+                    m_buffer += char(0xA0 | value.size());
+                } else if (value.size() <= UINT8_MAX) {
+                    writeNumber<uint8_t>(0xD9, uint8_t(value.size()));
+                } else if (value.size() <= UINT16_MAX) {
+                    writeNumber<uint16_t>(0xDA, uint16_t(value.size()));
+                } else {
+                    writeNumber<uint32_t>(0xDB, uint32_t(value.size()));
+                }
+                m_buffer.append(value.data(), value.size());
+            }
+
+        protected:
+            /// @brief Writes a map or array header, fix is the type byte of the 4-bit form, wide the one of the 16-bit form
+            void writeHeader(size_t count, uint8_t fix, uint8_t wide) {
+                if (count < 16) {
+                    m_buffer += char(fix | count);
+                } else if (count <= UINT16_MAX) {
+                    writeNumber<uint16_t>(wide, uint16_t(count));
+                } else {
+                    writeNumber<uint32_t>(wide + 1, uint32_t(count));
+                }
+            }
+
+            /// @brief Writes a type byte followed by a big-endian number
+            template<typename T>
+            void writeNumber(uint8_t type, T number) {
+                m_buffer += char(type);
+                for (size_t shift = sizeof(T) * 8; shift > 0; shift -= 8) {
+                    m_buffer += char(uint8_t(number >> (shift - 8)));
+                }
+            }
         };
-        json["seed"] = rand(); // absolute, pls fix (make seed optional)
-        json["version"] = 1.0;
-
-        // Set inputs
-        json["inputs"] = nlohmann::json::array();
-        for (const auto &frame : macro.getFrames()) {
-            // Check if the frame already exists
-            if (!json["inputs"].empty()) {
-                auto &lastFrame = json["inputs"].back();
-                if (lastFrame["frame"].get<uint32_t>() == frame.getFrame()) {
+
+        /// @brief Writes a replay in the MegaHack flavour of GDR, keys are sorted like in nlohmann::json objects
+        template<typename Writer>
+        bool writeReplay(const Macro &macro, Writer &writer) {
+            const auto &frames = macro.getFrames();
+            const auto &frameFixes = macro.getFrameFixes();
+            const auto &player1 = frameFixes.getPlayer1Columns();
+
+            // Only the first action of each frame is kept
+            auto isWritten = [&frames](size_t index) {
+                return index == 0 || frames[index - 1].getFrame() != frames[index].getFrame();
+            };
+            size_t inputCount = 0;
+            for (size_t i = 0; i < frames.size(); i++) {
+                inputCount += isWritten(i);
+            }
+
+            writer.beginObject(11);
+            writer.key("author");
+            writer.writeString("");
+            writer.key("bot");
+            writer.beginObject(2);
+            writer.key("name");
+            writer.writeString("Zephyrus");
+            writer.key("version");
+            writer.writeString("2");
+            writer.endObject();
+            writer.key("coins");
+            writer.writeInteger(0);
+            writer.key("description");
+            writer.writeString("");
+            writer.key("duration");
+            writer.writeUnsigned(frames.empty() ? 0 : frames.back().getFrame());
+            writer.key("gameVersion");
+            writer.writeFloat(2.204);
+
+            // Actions and frame fixes are both sorted by frame, so a single pass over each pairs them up
+            writer.key("inputs");
+            writer.beginArray(inputCount);
+            size_t frameFix = 0;
+            for (size_t i = 0; i < frames.size(); i++) {
+                if (!isWritten(i)) {
                     continue;
                 }
+                const auto &frame = frames[i];
+
+                // Set frame fix (use MegaHack format), with the first fix on the frame
+                while (frameFix < frameFixes.size() && frameFixes.getFrame(frameFix) < frame.getFrame()) {
+                    frameFix++;
+                }
+                bool hasFrameFix = frameFix < frameFixes.size() && frameFixes.getFrame(frameFix) == frame.getFrame();
+
+                writer.beginObject(hasFrameFix ? 8 : 4);
+                writer.key("2p");
+                writer.writeBool(frame.isSecondPlayer());
+                writer.key("btn");
+                writer.writeUnsigned(static_cast<uint8_t>(frame.getButton()));
+                writer.key("down");
+                writer.writeBool(frame.isPressed());
+                writer.key("frame");
+                writer.writeUnsigned(frame.getFrame());
+                if (hasFrameFix) {
+                    writer.key("mhr_meta");
+                    writer.writeBool(true);
+                    writer.key("mhr_x");
+                    writer.writeFloat(player1.x[frameFix]);
+                    writer.key("mhr_y");
+                    writer.writeFloat(player1.y[frameFix]);
+                    writer.key("mhr_yvel");
+                    writer.writeFloat(player1.ySpeed[frameFix]);
+                }
+                writer.endObject();
             }
+            writer.endArray();
+
+            writer.key("ldm");
+            writer.writeBool(false);
+            writer.key("level");
+            writer.beginObject(2);
+            writer.key("id");
+            writer.writeInteger(0);
+            writer.key("name");
+            writer.writeString("");
+            writer.endObject();
+            writer.key("seed");
+            writer.writeInteger(rand()); // absolute, pls fix (make seed optional)
+            writer.key("version");
+            writer.writeFloat(1.0);
+            writer.endObject();
+
+            return writer.finish();
+        }
+    }
+
+    bool isReplayPath(const std::filesystem::path &path) {
+        auto extension = path.extension();
+        return extension == ".gdr" || (extension == ".json" && path.stem().extension() == ".gdr");
+    }
 
-            nlohmann::json input;
-            input["2p"] = frame.isSecondPlayer();
-            input["btn"] = static_cast<uint8_t>(frame.getButton());
-            input["down"] = frame.isPressed();
-            input["frame"] = frame.getFrame();
+    bool writeToFile(const Macro &macro, const std::filesystem::path &path) {
+        WriteOptions options;
+        options.encoding = path.extension() == ".json" ? Encoding::CompactJSON : Encoding::MessagePack;
+        return writeToFile(macro, path, options);
+    }
 
-            // Set frame fix (use MegaHack format)
-            auto frameFix = macro.getFrameFixes(frame.getFrame());
-            if (!frameFix.empty()) {
-                auto &fix = frameFix[0];
-                input["mhr_meta"] = true;
-                input["mhr_x"] = fix.getPlayer1().x;
-                input["mhr_y"] = fix.getPlayer1().y;
-                input["mhr_yvel"] = fix.getPlayer1().ySpeed;
+    bool writeToFile(const Macro &macro, const std::filesystem::path &path, const WriteOptions &options) {
+        // Like native macros, the replay is streamed to a temporary file that replaces the destination once it is
+        // complete, so that a failed or interrupted export never leaves a truncated replay behind
+        auto temporaryPath = FileReader::getTemporaryPath(path);
+        bool written = false;
+        {
+            std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+            if (!file) {
+                return false;
             }
 
-            json["inputs"].push_back(input);
+            switch (options.encoding) {
+                case Encoding::JSON: {
+                    JsonWriter writer(file, 4);
+                    written = writeReplay(macro, writer);
+                    break;
+                }
+                case Encoding::CompactJSON: {
+                    JsonWriter writer(file, -1);
+                    written = writeReplay(macro, writer);
+                    break;
+                }
+                case Encoding::MessagePack: {
+                    MessagePackWriter writer(file);
+                    written = writeReplay(macro, writer);
+                    break;
+                }
+            }
         }
 
-        std::ofstream file(path, std::ios::binary);
-        file << json.dump(4);
-        file.close();
+        if (!written) {
+            std::error_code error;
+            std::filesystem::remove(temporaryPath, error);
+            return false;
+        }
+        return FileReader::commitTemporaryFile(temporaryPath, path);
     }
 
 }
\ No newline at end of file
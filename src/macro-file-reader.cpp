@@ -0,0 +1,238 @@
+#include <zephyrus/macro-file-reader.hpp>
+
+#include <algorithm>
+
+#include "file-chunks.hpp"
+#include "file-reader.hpp"
+
+namespace zephyrus {
+
+    namespace {
+        /// @brief Minimum number of bytes read from the file at once
+        constexpr size_t ReadSize = 64 * 1024;
+    }
+
+    bool MacroFileReader::open(const std::filesystem::path &path) {
+        close();
+
+        std::error_code error;
+        m_fileSize = std::filesystem::file_size(path, error);
+        if (error) {
+            return false;
+        }
+
+        m_file.open(path, std::ios::binary);
+        if (!m_file.is_open() || !fill(std::min<uint64_t>(FileReader::FileHeaderV3Size, m_fileSize)) ||
+            m_fileSize < FileReader::FileHeaderSize) {
+            close();
+            return false;
+        }
+
+        FileReader::BufferReader reader(m_buffer.data(), m_buffer.size());
+        m_header = FileReader::readFileHeader(reader);
+
+        bool valid = m_header.magic == 0x525A;
+        if (m_header.version == 2) {
+            // Every fix takes at least one player, which allows rejecting broken counts early
+            valid &= m_fileSize - FileReader::FileHeaderSize >=
+                     m_header.actionCount * uint64_t(FileReader::FileActionSize) +
+                     m_header.frameFixCount * uint64_t(FileReader::FileFrameFixSize);
+        } else {
+            valid &= m_header.version == 3 && reader.position() == FileReader::FileHeaderV3Size &&
+                     FileChunks::isSupportedCodec(m_header.codec);
+        }
+        if (!valid) {
+            close();
+            return false;
+        }
+
+        m_bufferPosition = reader.position();
+        m_actionsRemaining = m_header.actionCount;
+        m_frameFixesRemaining = m_header.frameFixCount;
+        m_chunksRemaining = m_header.chunkCount;
+        return true;
+    }
+
+    void MacroFileReader::close() {
+        m_file.close();
+        m_fileSize = 0;
+        m_filePosition = 0;
+        m_buffer.clear();
+        m_bufferPosition = 0;
+        m_header = {};
+        m_actionsRemaining = 0;
+        m_frameFixesRemaining = 0;
+        m_chunksRemaining = 0;
+        m_failed = false;
+        m_index.clear();
+        m_hasIndex = false;
+    }
+
+    bool MacroFileReader::readBatch(Batch &batch) {
+        batch.clear();
+        if (!isOpen() || m_failed) {
+            return false;
+        }
+
+        return m_header.version == 3 ? readChunk(batch) : readRecords(batch);
+    }
+
+    bool MacroFileReader::seek(uint32_t frame) {
+        if (!isOpen()) {
+            return false;
+        }
+
+        if (m_header.version == 3) {
+            uint64_t indexOffset = 0;
+            if (!m_hasIndex && !FileChunks::readIndex(m_file, m_fileSize, m_header.chunkCount, m_index, indexOffset)) {
+                m_index.clear();
+                reposition(FileReader::FileHeaderV3Size, 0, 0, 0);
+                return true;
+            }
+            m_hasIndex = true;
+
+            size_t chunk = FileChunks::findChunks(m_index, frame, UINT32_MAX).first;
+            if (chunk == m_index.size()) {
+                // Nothing left after the frame
+                reposition(m_fileSize, m_header.actionCount, m_header.frameFixCount, m_header.chunkCount);
+            } else {
+                const auto &entry = m_index[chunk];
+                if (entry.firstAction > m_header.actionCount || entry.firstFrameFix > m_header.frameFixCount) {
+                    return fail();
+                }
+                reposition(entry.offset, entry.firstAction, entry.firstFrameFix, uint32_t(chunk));
+            }
+            return true;
+        }
+
+        reposition(FileReader::FileHeaderSize, 0, 0, 0);
+        return true;
+    }
+
+    void MacroFileReader::reposition(uint64_t offset, uint32_t actionsRead, uint32_t frameFixesRead,
+                                     uint32_t chunksRead) {
+        m_file.clear();
+        m_file.seekg(static_cast<std::streamoff>(offset));
+        m_filePosition = offset;
+        m_buffer.clear();
+        m_bufferPosition = 0;
+        m_actionsRemaining = m_header.actionCount - actionsRead;
+        m_frameFixesRemaining = m_header.frameFixCount - frameFixesRead;
+        m_chunksRemaining = m_header.chunkCount - chunksRead;
+        m_failed = false;
+    }
+
+    bool MacroFileReader::fill(size_t count) {
+        size_t available = m_buffer.size() - m_bufferPosition;
+        if (available >= count) {
+            return true;
+        }
+
+        // Drop the consumed bytes, then read at least ReadSize more to keep the number of reads low
+        m_buffer.erase(m_buffer.begin(), m_buffer.begin() + static_cast<std::ptrdiff_t>(m_bufferPosition));
+        m_bufferPosition = 0;
+
+        size_t size = std::min<uint64_t>(std::max(count - available, ReadSize), m_fileSize - m_filePosition);
+        if (size < count - available) {
+            return false;
+        }
+
+        m_buffer.resize(available + size);
+        m_file.read(reinterpret_cast<char *>(m_buffer.data() + available), static_cast<std::streamsize>(size));
+        if (static_cast<size_t>(m_file.gcount()) != size) {
+            m_buffer.resize(available);
+            return false;
+        }
+        m_filePosition += size;
+        return true;
+    }
+
+    bool MacroFileReader::readChunk(Batch &batch) {
+        if (m_chunksRemaining == 0) {
+            return m_actionsRemaining == 0 && m_frameFixesRemaining == 0 ? false : fail();
+        }
+
+        if (!fill(FileChunks::ChunkHeaderSize)) {
+            return fail();
+        }
+
+        FileReader::BufferReader reader(m_buffer.data() + m_bufferPosition, m_buffer.size() - m_bufferPosition);
+        MacroFileChunk chunk = FileChunks::readChunkHeader(reader);
+        m_bufferPosition += FileChunks::ChunkHeaderSize;
+
+        if (chunk.actionCount > m_actionsRemaining || chunk.frameFixCount > m_frameFixesRemaining ||
+            !fill(chunk.payloadSize)) {
+            return fail();
+        }
+
+        size_t storedSize = chunk.payloadSize;
+        const uint8_t *payload = m_buffer.data() + m_bufferPosition;
+        if (!FileChunks::unpackChunk(chunk, payload, m_header.codec, m_payload) ||
+            !FileChunks::decodeChunk(chunk, payload, batch.actions, batch.frameFixes)) {
+            return fail();
+        }
+
+        m_bufferPosition += storedSize;
+        m_actionsRemaining -= chunk.actionCount;
+        m_frameFixesRemaining -= chunk.frameFixCount;
+        m_chunksRemaining--;
+        return true;
+    }
+
+    bool MacroFileReader::readRecords(Batch &batch) {
+        if (m_actionsRemaining > 0) {
+            size_t count = std::min<size_t>(m_actionsRemaining, BatchSize);
+            if (!fill(count * FileReader::FileActionSize)) {
+                return fail();
+            }
+
+            FileReader::BufferReader reader(m_buffer.data() + m_bufferPosition, m_buffer.size() - m_bufferPosition);
+            batch.actions.reserve(count);
+            for (size_t i = 0; i < count; i++) {
+                MacroFileAction action = FileReader::readFileAction(reader);
+                batch.actions.emplace_back(action.frame, action.flags);
+            }
+
+            m_bufferPosition += reader.position();
+            m_actionsRemaining -= count;
+            return true;
+        }
+
+        if (m_frameFixesRemaining == 0) {
+            return false;
+        }
+
+        size_t count = std::min<size_t>(m_frameFixesRemaining, BatchSize);
+        batch.frameFixes.reserve(count);
+        for (size_t i = 0; i < count; i++) {
+            // The player 2 flag is the last byte of the record without player 2 data
+            if (!fill(FileReader::FileFrameFixSize)) {
+                return fail();
+            }
+            bool player2Exists = m_buffer[m_bufferPosition + FileReader::FileFrameFixSize - 1] != 0;
+            if (player2Exists && !fill(FileReader::FileFrameFixSize + FileReader::PlayerDataSize)) {
+                return fail();
+            }
+
+            FileReader::BufferReader reader(m_buffer.data() + m_bufferPosition, m_buffer.size() - m_bufferPosition);
+            uint32_t frame = reader.read<uint32_t>();
+            auto player1 = FileReader::readPlayerData(reader);
+            reader.skip(1);
+            if (player2Exists) {
+                batch.frameFixes.emplace_back(frame, player1, FileReader::readPlayerData(reader));
+            } else {
+                batch.frameFixes.emplace_back(frame, player1);
+            }
+            m_bufferPosition += reader.position();
+        }
+
+        m_frameFixesRemaining -= count;
+        return true;
+    }
+
+    bool MacroFileReader::fail() {
+        m_failed = true;
+        return false;
+    }
+
+}
@@ -0,0 +1,280 @@
+#include <zephyrus/macro-stream.hpp>
+
+#include <algorithm>
+
+namespace zephyrus {
+
+    MacroStream::MacroStream(size_t capacity) : m_slots(std::max<size_t>(capacity, 1)) {}
+
+    bool MacroStream::open(const std::filesystem::path &path) {
+        close();
+
+        if (!m_reader.open(path) || m_reader.getHeader().version != 3) {
+            m_reader.close();
+            return false;
+        }
+
+        m_header = m_reader.getHeader();
+        m_oldest.store(0, std::memory_order_relaxed);
+        m_head.store(0, std::memory_order_relaxed);
+        m_tail.store(0, std::memory_order_relaxed);
+        m_requestedGeneration.store(0, std::memory_order_relaxed);
+        m_requestedFrame.store(0, std::memory_order_relaxed);
+        m_finishedGeneration.store(UINT32_MAX, std::memory_order_relaxed);
+        m_failed.store(false, std::memory_order_relaxed);
+        m_stopping.store(false, std::memory_order_relaxed);
+        m_readerGeneration = 0;
+
+        // Same starting point as a playback cursor on frame 0
+        m_generation = 0;
+        m_frame = 0;
+        m_actionFloor = 0;
+        m_frameFixFloor = 0;
+        m_actionIndex = 0;
+        m_frameFixIndex = 0;
+        m_underrunCount = 0;
+
+        // The first batch is decoded right away, so that playback can start without an underrun
+        if (!decodeSlot(0)) {
+            m_finishedGeneration.store(0, std::memory_order_relaxed);
+        }
+
+        m_thread = std::thread(&MacroStream::run, this);
+        return true;
+    }
+
+    void MacroStream::close() {
+        if (m_thread.joinable()) {
+            m_stopping.store(true, std::memory_order_release);
+            wakeUp();
+            m_thread.join();
+        }
+        m_reader.close();
+        m_header = {};
+    }
+
+    bool MacroStream::advance(uint32_t frame, Step &step) {
+        step.frames.clear();
+        step.frameFixes.clear();
+        if (!isOpen()) {
+            return true;
+        }
+        if (step.frames.capacity() < MacroFileReader::BatchSize ||
+            step.frameFixes.capacity() < MacroFileReader::BatchSize) {
+            step.reserve();
+        }
+
+        // Going backwards requires a new starting point
+        if (frame < m_frame) {
+            seek(frame);
+        }
+        m_frame = frame;
+
+        while (true) {
+            size_t head = m_head.load(std::memory_order_relaxed);
+            if (head == m_tail.load(std::memory_order_acquire)) {
+                // Out of decoded batches: either everything was played, or the background thread fell behind
+                if (m_finishedGeneration.load(std::memory_order_acquire) == m_generation) {
+                    return true;
+                }
+                m_underrunCount++;
+                return false;
+            }
+
+            const Slot &slot = m_slots[head % m_slots.size()];
+            if (slot.generation != m_generation) {
+                // Decoded before the last seek, so nothing before it is worth keeping either
+                m_actionIndex = 0;
+                m_frameFixIndex = 0;
+                m_head.store(head + 1, std::memory_order_relaxed);
+                m_oldest.store(head + 1, std::memory_order_release);
+                wakeUp();
+                continue;
+            }
+
+            // The step never grows, entries that do not fit are left for the next advance
+            const auto &actions = slot.batch.actions;
+            while (m_actionIndex < actions.size() && actions[m_actionIndex].getFrame() <= frame) {
+                if (actions[m_actionIndex].getFrame() > m_actionFloor) {
+                    if (step.frames.size() == step.frames.capacity()) {
+                        m_underrunCount++;
+                        return false;
+                    }
+                    step.frames.push_back(actions[m_actionIndex]);
+                }
+                m_actionIndex++;
+            }
+
+            const auto &frameFixes = slot.batch.frameFixes;
+            while (m_frameFixIndex < frameFixes.size() && frameFixes[m_frameFixIndex].getFrame() <= frame) {
+                if (frameFixes[m_frameFixIndex].getFrame() >= m_frameFixFloor) {
+                    if (step.frameFixes.size() == step.frameFixes.capacity()) {
+                        m_underrunCount++;
+                        return false;
+                    }
+                    step.frameFixes.push_back(frameFixes[m_frameFixIndex]);
+                }
+                m_frameFixIndex++;
+            }
+
+            if (m_actionIndex < actions.size() || m_frameFixIndex < frameFixes.size()) {
+                // The rest of the batch is after the frame
+                return true;
+            }
+            popSlot();
+        }
+    }
+
+    void MacroStream::seek(uint32_t frame) {
+        if (!isOpen()) {
+            return;
+        }
+
+        bool backwards = frame < m_frame;
+        bool moved = frame != m_frame;
+        m_frame = frame;
+        m_actionFloor = frame;
+        m_frameFixFloor = frame;
+        if (!moved || seekRetained(frame, backwards)) {
+            return;
+        }
+
+        // The batches in the ring are dropped, and the background thread moves the reader with the file index.
+        // The reader is only used by that thread, so the playback side never waits for the disk.
+        m_generation++;
+        m_actionIndex = 0;
+        m_frameFixIndex = 0;
+        size_t tail = m_tail.load(std::memory_order_acquire);
+        m_head.store(tail, std::memory_order_relaxed);
+        m_oldest.store(tail, std::memory_order_release);
+        m_requestedFrame.store(frame, std::memory_order_relaxed);
+        m_requestedGeneration.store(m_generation, std::memory_order_release);
+        wakeUp();
+    }
+
+    bool MacroStream::seekRetained(uint32_t frame, bool backwards) {
+        // Entries before the frame are skipped by advance, and chunks never share a frame, so the ring can be used
+        // when its first batch starts on or before the frame, and every batch in it was decoded since the last seek
+        size_t head = m_head.load(std::memory_order_relaxed);
+        size_t tail = m_tail.load(std::memory_order_acquire);
+        size_t start = backwards ? m_oldest.load(std::memory_order_relaxed) : head;
+        if (backwards) {
+            if (start == tail) {
+                return false;
+            }
+            const Slot &first = m_slots[start % m_slots.size()];
+            if (!first.first && first.firstFrame > frame) {
+                return false;
+            }
+        }
+
+        size_t target = start;
+        while (target != tail) {
+            const Slot &slot = m_slots[target % m_slots.size()];
+            if (slot.generation != m_generation) {
+                return false;
+            }
+            if (slot.lastFrame >= frame) {
+                break;
+            }
+            target++;
+        }
+
+        // Going forward past the decoded batches is left to the file index, unless every batch was decoded
+        if (target == tail && !backwards && m_finishedGeneration.load(std::memory_order_acquire) != m_generation) {
+            return false;
+        }
+        if (backwards || target != head) {
+            m_head.store(target, std::memory_order_relaxed);
+            m_actionIndex = 0;
+            m_frameFixIndex = 0;
+        }
+        return true;
+    }
+
+    void MacroStream::popSlot() {
+        m_actionIndex = 0;
+        m_frameFixIndex = 0;
+        size_t head = m_head.load(std::memory_order_relaxed) + 1;
+        m_head.store(head, std::memory_order_relaxed);
+
+        // The oldest played batches make room for the background thread
+        if (head - m_oldest.load(std::memory_order_relaxed) > getRetainedCount()) {
+            m_oldest.store(head - getRetainedCount(), std::memory_order_release);
+            wakeUp();
+        }
+    }
+
+    void MacroStream::wakeUp() {
+        // The background thread checks its work with the mutex held, so it either sees the new state,
+        // or it is already waiting and gets the notification
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_wakeup.notify_one();
+    }
+
+    bool MacroStream::hasWork() const {
+        if (m_requestedGeneration.load(std::memory_order_acquire) != m_readerGeneration) {
+            return true;
+        }
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+        return m_finishedGeneration.load(std::memory_order_relaxed) != m_readerGeneration &&
+               tail - m_oldest.load(std::memory_order_acquire) < m_slots.size();
+    }
+
+    void MacroStream::run() {
+        while (!m_stopping.load(std::memory_order_acquire)) {
+            {
+                // Nothing to do until the playback side frees a slot, seeks or closes the stream
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_wakeup.wait(lock, [this] { return m_stopping.load(std::memory_order_acquire) || hasWork(); });
+            }
+            if (m_stopping.load(std::memory_order_acquire)) {
+                break;
+            }
+
+            // The frame is written before the generation, so it belongs to this seek or a later one
+            uint32_t generation = m_requestedGeneration.load(std::memory_order_acquire);
+            if (generation != m_readerGeneration) {
+                m_readerGeneration = generation;
+                if (!m_reader.seek(m_requestedFrame.load(std::memory_order_relaxed))) {
+                    m_failed.store(true, std::memory_order_release);
+                    m_finishedGeneration.store(generation, std::memory_order_release);
+                    continue;
+                }
+            }
+
+            if (hasWork() && !decodeSlot(m_readerGeneration)) {
+                m_finishedGeneration.store(m_readerGeneration, std::memory_order_release);
+            }
+        }
+    }
+
+    bool MacroStream::decodeSlot(uint32_t generation) {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+        Slot &slot = m_slots[tail % m_slots.size()];
+        bool first = m_reader.getActionsRead() == 0 && m_reader.getFrameFixesRead() == 0;
+        if (!m_reader.readBatch(slot.batch)) {
+            if (m_reader.hasFailed()) {
+                m_failed.store(true, std::memory_order_release);
+            }
+            return false;
+        }
+
+        const auto &batch = slot.batch;
+        slot.generation = generation;
+        slot.first = first;
+        slot.firstFrame = UINT32_MAX;
+        slot.lastFrame = 0;
+        if (!batch.actions.empty()) {
+            slot.firstFrame = batch.actions.front().getFrame();
+            slot.lastFrame = batch.actions.back().getFrame();
+        }
+        if (!batch.frameFixes.empty()) {
+            slot.firstFrame = std::min(slot.firstFrame, batch.frameFixes.front().getFrame());
+            slot.lastFrame = std::max(slot.lastFrame, batch.frameFixes.back().getFrame());
+        }
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+}
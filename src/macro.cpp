@@ -1,66 +1,503 @@
 #include <zephyrus/macro.hpp>
 
+#include <algorithm>
+
 namespace zephyrus {
 
+    namespace {
+        /// @brief Returns the number of set bits in a 64-bit word
+        size_t popCount(uint64_t value) {
+            value = value - ((value >> 1) & 0x5555555555555555ULL);
+            value = (value & 0x3333333333333333ULL) + ((value >> 2) & 0x3333333333333333ULL);
+            value = (value + (value >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+            return static_cast<size_t>((value * 0x0101010101010101ULL) >> 56);
+        }
+    }
+
+    void Macro::FrameFixStorage::PlayerColumns::insert(size_t index, const FrameFix::PlayerData &data) {
+        auto offset = static_cast<std::ptrdiff_t>(index);
+        x.insert(x.begin() + offset, data.x);
+        y.insert(y.begin() + offset, data.y);
+        ySpeed.insert(ySpeed.begin() + offset, data.ySpeed);
+        rotation.insert(rotation.begin() + offset, data.rotation);
+    }
+
+    void Macro::FrameFixStorage::PlayerColumns::resize(size_t count) {
+        x.resize(count);
+        y.resize(count);
+        ySpeed.resize(count);
+        rotation.resize(count);
+    }
+
+    void Macro::FrameFixStorage::PlayerColumns::reserve(size_t count) {
+        x.reserve(count);
+        y.reserve(count);
+        ySpeed.reserve(count);
+        rotation.reserve(count);
+    }
+
+    void Macro::FrameFixStorage::PlayerColumns::shrinkToFit() {
+        x.shrink_to_fit();
+        y.shrink_to_fit();
+        ySpeed.shrink_to_fit();
+        rotation.shrink_to_fit();
+    }
+
+    void Macro::FrameFixStorage::PlayerColumns::clear() {
+        x.clear();
+        y.clear();
+        ySpeed.clear();
+        rotation.clear();
+    }
+
+    Macro::FrameFixStorage::FrameFixStorage(std::pmr::memory_resource *resource) :
+            m_presence(resource), m_presenceRank(resource), m_frame(resource), m_player1(resource),
+            m_player2Index(resource), m_player2(resource) {}
+
+    Macro::FrameFixStorage::FrameFixStorage(const FrameFixStorage &other, std::pmr::memory_resource *resource) :
+            m_dense(other.m_dense), m_baseFrame(other.m_baseFrame), m_slotCount(other.m_slotCount),
+            m_presence(other.m_presence, resource), m_presenceRank(other.m_presenceRank, resource),
+            m_frame(other.m_frame, resource), m_player1(other.m_player1, resource),
+            m_player2Index(other.m_player2Index, resource), m_player2(other.m_player2, resource) {}
+
+    const Macro::FrameFix Macro::FrameFixStorage::operator[](size_t index) const {
+        // Fixes with player 2 data are rare, so they are looked up in the sorted index
+        auto it = std::lower_bound(m_player2Index.begin(), m_player2Index.end(), index);
+        if (it != m_player2Index.end() && *it == index) {
+            return {getFrame(index), m_player1.get(index), m_player2.get(it - m_player2Index.begin())};
+        }
+        return {getFrame(index), m_player1.get(index)};
+    }
+
+    Macro::FrameFixStorage::Iterator::Iterator(const FrameFixStorage *storage, size_t index) :
+            m_storage(storage), m_index(index) {
+        const auto &player2Index = storage->m_player2Index;
+        m_player2 = std::lower_bound(player2Index.begin(), player2Index.end(), index) - player2Index.begin();
+        if (storage->m_dense && index < storage->size()) {
+            m_slot = storage->selectSlot(index);
+        }
+    }
+
+    const Macro::FrameFix Macro::FrameFixStorage::Iterator::operator*() const {
+        const auto &storage = *m_storage;
+        uint32_t frame = storage.m_dense
+                ? storage.m_baseFrame + static_cast<uint32_t>(m_slot != UnknownSlot ? m_slot : storage.selectSlot(m_index))
+                : storage.m_frame[m_index];
+        if (m_player2 < storage.m_player2Index.size() && storage.m_player2Index[m_player2] == m_index) {
+            return {frame, storage.m_player1.get(m_index), storage.m_player2.get(m_player2)};
+        }
+        return {frame, storage.m_player1.get(m_index)};
+    }
+
+    Macro::FrameFixStorage::Iterator &Macro::FrameFixStorage::Iterator::operator++() {
+        const auto &storage = *m_storage;
+        if (m_player2 < storage.m_player2Index.size() && storage.m_player2Index[m_player2] == m_index) {
+            m_player2++;
+        }
+        m_index++;
+
+        if (storage.m_dense) {
+            if (m_index >= storage.size()) {
+                m_slot = UnknownSlot;
+            } else {
+                m_slot = m_slot != UnknownSlot ? storage.nextSlot(m_slot + 1) : storage.selectSlot(m_index);
+            }
+        }
+        return *this;
+    }
+
+    std::vector<Macro::FrameFix> Macro::FrameFixStorage::toVector() const {
+        std::vector<FrameFix> frameFixes;
+        frameFixes.reserve(size());
+        frameFixes.assign(begin(), end());
+        return frameFixes;
+    }
+
+    size_t Macro::FrameFixStorage::rankSlot(size_t slot) const {
+        if (slot >= m_slotCount) return size();
+        size_t word = slot / 64;
+        uint64_t mask = (uint64_t(1) << (slot % 64)) - 1;
+        return m_presenceRank[word] + popCount(m_presence[word] & mask);
+    }
+
+    size_t Macro::FrameFixStorage::selectSlot(size_t index) const {
+        // Find the last word that starts at or before the fix, then the bit inside of it
+        size_t word = std::upper_bound(m_presenceRank.begin(), m_presenceRank.end(), index) - m_presenceRank.begin() - 1;
+        uint64_t bits = m_presence[word];
+        for (size_t skip = index - m_presenceRank[word]; skip > 0; skip--) {
+            bits &= bits - 1;
+        }
+
+        size_t bit = 0;
+        while (!(bits & (uint64_t(1) << bit))) bit++;
+        return word * 64 + bit;
+    }
+
+    size_t Macro::FrameFixStorage::nextSlot(size_t slot) const {
+        // The bitmap is at least 1/MaxSlotsPerDenseFix full, so this only skips a few words
+        size_t word = slot / 64;
+        uint64_t bits = m_presence[word] & (~uint64_t(0) << (slot % 64));
+        while (!bits) {
+            bits = m_presence[++word];
+        }
+        return word * 64 + popCount((bits & (~bits + 1)) - 1);
+    }
+
+    bool Macro::FrameFixStorage::appendDense(uint32_t frame) {
+        if (empty()) {
+            m_baseFrame = frame;
+        } else if (frame < m_baseFrame || frame - m_baseFrame < m_slotCount) {
+            return false; // Duplicate or older frame
+        }
+
+        size_t slot = frame - m_baseFrame;
+        if (slot + 1 > MaxSlotsPerDenseFix * (size() + 1)) {
+            return false;
+        }
+
+        while (m_presence.size() <= slot / 64) {
+            m_presence.push_back(0);
+            m_presenceRank.push_back(static_cast<uint32_t>(size()));
+        }
+
+        m_presence[slot / 64] |= uint64_t(1) << (slot % 64);
+        m_slotCount = slot + 1;
+        return true;
+    }
+
+    void Macro::FrameFixStorage::convertToSparse() {
+        m_frame.clear();
+        m_frame.reserve(size());
+        for (size_t word = 0; word < m_presence.size(); word++) {
+            for (uint64_t bits = m_presence[word]; bits; bits &= bits - 1) {
+                size_t bit = 0;
+                while (!(bits & (uint64_t(1) << bit))) bit++;
+                m_frame.push_back(m_baseFrame + static_cast<uint32_t>(word * 64 + bit));
+            }
+        }
+
+        m_dense = false;
+        m_slotCount = 0;
+        m_presence.clear();
+        m_presenceRank.clear();
+    }
+
+    size_t Macro::FrameFixStorage::lowerBound(uint32_t frame) const {
+        if (m_dense) {
+            if (frame <= m_baseFrame) return 0;
+            return rankSlot(frame - m_baseFrame);
+        }
+        return std::lower_bound(m_frame.begin(), m_frame.end(), frame) - m_frame.begin();
+    }
+
+    size_t Macro::FrameFixStorage::upperBound(uint32_t frame) const {
+        if (m_dense) {
+            if (frame < m_baseFrame) return 0;
+            size_t slot = frame - m_baseFrame;
+            if (slot >= m_slotCount) return size();
+            return rankSlot(slot) + ((m_presence[slot / 64] >> (slot % 64)) & 1);
+        }
+        return std::upper_bound(m_frame.begin(), m_frame.end(), frame) - m_frame.begin();
+    }
+
+    Macro::FrameFixStorage::Iterator Macro::FrameFixStorage::upperBound(Iterator from, uint32_t frame) const {
+        Iterator it = from;
+        if (m_dense) {
+            it.m_index = upperBound(frame);
+            it.m_slot = Iterator::UnknownSlot;
+            if (it.m_index < size()) {
+                it.m_slot = frame < m_baseFrame ? 0 : nextSlot(frame - m_baseFrame + 1);
+            }
+        } else {
+            while (it.m_index < size() && m_frame[it.m_index] <= frame) {
+                it.m_index++;
+            }
+        }
+
+        // Only the fixes that were passed are visited
+        while (it.m_player2 < m_player2Index.size() && m_player2Index[it.m_player2] < it.m_index) {
+            it.m_player2++;
+        }
+        return it;
+    }
+
+    void Macro::FrameFixStorage::insert(size_t index, uint32_t frame, const FrameFix::PlayerData &player1,
+                                        const FrameFix::PlayerData *player2) {
+        if (m_dense && !(index == size() && appendDense(frame))) {
+            convertToSparse();
+        }
+        if (!m_dense) {
+            m_frame.insert(m_frame.begin() + static_cast<std::ptrdiff_t>(index), frame);
+        }
+        m_player1.insert(index, player1);
+
+        // Shift the player 2 references that point past the new fix
+        auto it = std::lower_bound(m_player2Index.begin(), m_player2Index.end(), index);
+        for (auto shifted = it; shifted != m_player2Index.end(); ++shifted) {
+            ++*shifted;
+        }
+
+        if (player2) {
+            size_t position = it - m_player2Index.begin();
+            m_player2Index.insert(it, static_cast<uint32_t>(index));
+            m_player2.insert(position, *player2);
+        }
+    }
+
+    void Macro::FrameFixStorage::insertSorted(uint32_t frame, const FrameFix::PlayerData &player1,
+                                              const FrameFix::PlayerData *player2) {
+        if (!empty() && getFrame(size() - 1) > frame) {
+            return insert(upperBound(frame), frame, player1, player2);
+        }
+
+        if (m_dense && !appendDense(frame)) {
+            convertToSparse();
+        }
+        if (!m_dense) {
+            m_frame.push_back(frame);
+        }
+        if (player2) {
+            m_player2Index.push_back(static_cast<uint32_t>(size()));
+            m_player2.push_back(*player2);
+        }
+        m_player1.push_back(player1);
+    }
+
+    void Macro::FrameFixStorage::truncate(size_t count) {
+        if (count >= size()) return;
+        if (count == 0) {
+            // Start over, so that the next recording can pick dense mode again
+            clear();
+            return;
+        }
+
+        if (m_dense) {
+            m_slotCount = selectSlot(count - 1) + 1;
+            size_t words = (m_slotCount + 63) / 64;
+            m_presence.resize(words);
+            m_presenceRank.resize(words);
+            if (m_slotCount % 64) {
+                m_presence.back() &= (uint64_t(1) << (m_slotCount % 64)) - 1;
+            }
+        } else {
+            m_frame.resize(count);
+        }
+        m_player1.resize(count);
+
+        size_t player2Count = std::lower_bound(m_player2Index.begin(), m_player2Index.end(), count) - m_player2Index.begin();
+        m_player2Index.resize(player2Count);
+        m_player2.resize(player2Count);
+    }
+
+    void Macro::FrameFixStorage::resizeForLoad(size_t count) {
+        // The frames go to the frame column first, so that they can be set concurrently
+        clear();
+        m_dense = false;
+        m_frame.resize_uninitialized(count);
+        m_player1.x.resize_uninitialized(count);
+        m_player1.y.resize_uninitialized(count);
+        m_player1.ySpeed.resize_uninitialized(count);
+        m_player1.rotation.resize_uninitialized(count);
+    }
+
+    void Macro::FrameFixStorage::finishLoad() {
+        size_t count = size();
+        if (count == 0) {
+            clear();
+            return;
+        }
+
+        // Builds the bitmap a word at a time, with the same conditions as appendDense for every prefix of the fixes
+        uint32_t baseFrame = m_frame[0];
+        uint32_t previousFrame = baseFrame;
+        uint64_t bits = 0;
+        size_t word = 0;
+        uint32_t wordRank = 0;
+        for (size_t i = 0; i < count; i++) {
+            uint32_t frame = m_frame[i];
+            size_t slot = frame - baseFrame;
+            if ((i > 0 && frame <= previousFrame) || slot + 1 > MaxSlotsPerDenseFix * (i + 1)) {
+                m_presence.clear();
+                m_presenceRank.clear();
+                return;
+            }
+            previousFrame = frame;
+
+            while (slot / 64 > word) {
+                m_presence.push_back(bits);
+                m_presenceRank.push_back(wordRank);
+                bits = 0;
+                word++;
+                wordRank = static_cast<uint32_t>(i);
+            }
+            bits |= uint64_t(1) << (slot % 64);
+        }
+        m_presence.push_back(bits);
+        m_presenceRank.push_back(wordRank);
+
+        m_dense = true;
+        m_baseFrame = baseFrame;
+        m_slotCount = previousFrame - baseFrame + size_t(1);
+        m_frame.clear();
+        m_frame.shrink_to_fit();
+    }
+
+    void Macro::FrameFixStorage::reserve(size_t count) {
+        if (!m_dense) {
+            m_frame.reserve(count);
+        }
+        m_player1.reserve(count);
+    }
+
+    void Macro::FrameFixStorage::shrinkToFit() {
+        m_presence.shrink_to_fit();
+        m_presenceRank.shrink_to_fit();
+        m_frame.shrink_to_fit();
+        m_player1.shrinkToFit();
+        m_player2Index.shrink_to_fit();
+        m_player2.shrinkToFit();
+    }
+
+    void Macro::FrameFixStorage::clear() {
+        m_dense = true;
+        m_baseFrame = 0;
+        m_slotCount = 0;
+        m_presence.clear();
+        m_presenceRank.clear();
+        m_frame.clear();
+        m_player1.clear();
+        m_player2Index.clear();
+        m_player2.clear();
+    }
+
+    namespace {
+        /// @brief Returns the first entry with a frame number not less than the specified frame
+        template<typename Container>
+        auto lowerBound(const Container &container, uint32_t frame) {
+            return std::lower_bound(container.begin(), container.end(), frame, [](const auto &entry, uint32_t value) {
+                return entry.getFrame() < value;
+            });
+        }
+
+        /// @brief Returns the first entry with a frame number greater than the specified frame
+        template<typename Container>
+        auto upperBound(const Container &container, uint32_t frame) {
+            return std::upper_bound(container.begin(), container.end(), frame, [](uint32_t value, const auto &entry) {
+                return value < entry.getFrame();
+            });
+        }
+
+        /// @brief Adds an entry while keeping the container sorted by frame number
+        template<typename Container, typename... Args>
+        void insertSorted(Container &container, uint32_t frame, Args &&... args) {
+            if (container.empty() || container.back().getFrame() <= frame) {
+                container.emplace_back(frame, std::forward<Args>(args)...);
+            } else {
+                container.emplace(upperBound(container, frame), frame, std::forward<Args>(args)...);
+            }
+        }
+    }
+
+    void Macro::resizeForLoad(size_t frames, size_t frameFixes) {
+        m_frames.clear();
+        m_frames.resize(frames, Frame(0, 0));
+        m_frameFixes.resizeForLoad(frameFixes);
+    }
+
     void Macro::clearFrames(uint32_t from) {
-        m_frames.erase(std::remove_if(m_frames.begin(), m_frames.end(), [from](const Frame& frame) {
-            return frame.getFrame() >= from;
-        }), m_frames.end());
-        m_frameFixes.erase(std::remove_if(m_frameFixes.begin(), m_frameFixes.end(), [from](const FrameFix& frameFix) {
-            return frameFix.getFrame() >= from;
-        }), m_frameFixes.end());
+        // Both containers are sorted, so everything from the first matching entry to the end goes
+        m_frames.erase(lowerBound(m_frames, from), m_frames.end());
+        m_frameFixes.truncate(m_frameFixes.lowerBound(from));
+
+        if (m_frames.capacity() >= ShrinkMinCapacity && m_frames.size() * ShrinkFactor <= m_frames.capacity()) {
+            m_frames.shrink_to_fit();
+        }
+        if (m_frameFixes.capacity() >= ShrinkMinCapacity && m_frameFixes.size() * ShrinkFactor <= m_frameFixes.capacity()) {
+            m_frameFixes.shrinkToFit();
+        }
     }
 
     void Macro::addFrame(uint32_t frame, bool secondPlayer, PlayerButton button, bool pressed) {
-        m_frames.emplace_back(frame, secondPlayer, button, pressed);
+        insertSorted(m_frames, frame, secondPlayer, button, pressed);
+    }
+
+    void Macro::addFrame(uint32_t frame, uint8_t flags) {
+        insertSorted(m_frames, frame, flags);
     }
 
     void Macro::addFrameFix(uint32_t frame, FrameFix::PlayerData player1) {
-        m_frameFixes.emplace_back(frame, player1);
+        m_frameFixes.insertSorted(frame, player1, nullptr);
     }
 
     void Macro::addFrameFix(uint32_t frame, FrameFix::PlayerData player1, FrameFix::PlayerData player2) {
-        m_frameFixes.emplace_back(frame, player1, player2);
+        m_frameFixes.insertSorted(frame, player1, &player2);
     }
 
     std::vector<Macro::Frame> Macro::getFrames(uint32_t startFrame, uint32_t endFrame) const {
-        std::vector<Macro::Frame> frames;
-        for (const auto& frame : m_frames) {
-            if (frame.getFrame() >= startFrame && frame.getFrame() <= endFrame) {
-                frames.push_back(frame);
-            }
-        }
-        return frames;
+        auto view = getFramesView(startFrame, endFrame);
+        return {view.begin(), view.end()};
     }
 
     std::vector<Macro::Frame> Macro::getFrames(uint32_t frame) const {
-        std::vector<Macro::Frame> frames;
-        for (const auto& f : m_frames) {
-            if (f.getFrame() == frame) {
-                frames.push_back(f);
-            }
-        }
-        return frames;
+        auto view = getFramesView(frame);
+        return {view.begin(), view.end()};
     }
 
     std::vector<Macro::FrameFix> Macro::getFrameFixes(uint32_t startFrame, uint32_t endFrame) const {
-        std::vector<Macro::FrameFix> frameFixes;
-        for (const auto& frameFix : m_frameFixes) {
-            if (frameFix.getFrame() >= startFrame && frameFix.getFrame() <= endFrame) {
-                frameFixes.push_back(frameFix);
-            }
-        }
-        return frameFixes;
+        return getFrameFixesView(startFrame, endFrame).toVector();
     }
 
     std::vector<Macro::FrameFix> Macro::getFrameFixes(uint32_t frame) const {
-        std::vector<Macro::FrameFix> frameFixes;
-        for (const auto& f : m_frameFixes) {
-            if (f.getFrame() == frame) {
-                frameFixes.push_back(f);
-            }
+        return getFrameFixesView(frame).toVector();
+    }
+
+    Macro::FrameRange Macro::getFramesView(uint32_t startFrame, uint32_t endFrame) const {
+        if (startFrame > endFrame) return {m_frames.end(), m_frames.end()};
+        auto begin = lowerBound(m_frames, startFrame);
+        return {begin, std::upper_bound(begin, m_frames.end(), endFrame, [](uint32_t value, const Frame &f) {
+            return value < f.getFrame();
+        })};
+    }
+
+    Macro::FrameFixRange Macro::getFrameFixesView(uint32_t startFrame, uint32_t endFrame) const {
+        if (startFrame > endFrame) return {m_frameFixes.end(), m_frameFixes.end()};
+        return {m_frameFixes.begin() + static_cast<std::ptrdiff_t>(m_frameFixes.lowerBound(startFrame)),
+                m_frameFixes.begin() + static_cast<std::ptrdiff_t>(m_frameFixes.upperBound(endFrame))};
+    }
+
+    Macro::PlaybackCursor::Step Macro::PlaybackCursor::advance(uint32_t frame) {
+        const auto &frames = m_macro->m_frames;
+        const auto &frameFixes = m_macro->m_frameFixes;
+
+        // Going backwards (or the macro was truncated under us) requires a new starting point
+        if (frame < m_frame || m_frameIndex > frames.size() || m_frameFix.getIndex() > frameFixes.size()) {
+            seek(frame < m_frame ? frame : m_frame);
         }
-        return frameFixes;
+        m_frame = frame;
+
+        // Both indices only move forward, so advancing through the whole macro is linear in its size
+        size_t frameStart = m_frameIndex;
+        while (m_frameIndex < frames.size() && frames[m_frameIndex].getFrame() <= frame) {
+            m_frameIndex++;
+        }
+
+        // The iterator keeps its bitmap slot and player 2 position, so the fixes are not looked up again
+        auto frameFixStart = m_frameFix;
+        m_frameFix = frameFixes.upperBound(m_frameFix, frame);
+
+        return {
+            {frames.begin() + static_cast<std::ptrdiff_t>(frameStart), frames.begin() + static_cast<std::ptrdiff_t>(m_frameIndex)},
+            {frameFixStart, m_frameFix}
+        };
+    }
+
+    void Macro::PlaybackCursor::seek(uint32_t frame) {
+        const auto &frames = m_macro->m_frames;
+        const auto &frameFixes = m_macro->m_frameFixes;
+
+        m_frame = frame;
+        m_frameIndex = upperBound(frames, frame) - frames.begin();
+        m_frameFix = {&frameFixes, frameFixes.lowerBound(frame)};
     }
 
 }
\ No newline at end of file
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace zephyrus {
+
+    /// @brief Utility namespace for spreading independent tasks across cores
+    namespace Parallel {
+        /// @brief Fewer tasks than this are not worth starting threads for
+        constexpr size_t MinParallelTasks = 4;
+
+        /// @brief Number of results that can wait for the calling thread, per worker thread
+        constexpr size_t ResultsPerWorker = 2;
+
+        /// @brief Number of worker threads to use instead of the one derived from the cores, SIZE_MAX for the default
+        /// @note Only meant for benchmarks that measure how the parallel paths scale, on any number of cores
+        inline std::atomic<size_t> WorkerCountOverride{SIZE_MAX};
+
+        /// @brief Returns the number of worker threads to use for the specified number of tasks
+        /// @return 0 if the tasks should run on the calling thread
+        inline size_t getWorkerCount(size_t taskCount) {
+            size_t workerCount = WorkerCountOverride.load(std::memory_order_relaxed);
+            if (workerCount != SIZE_MAX) {
+                return taskCount < MinParallelTasks ? 0 : std::min(workerCount, taskCount);
+            }
+
+            size_t cores = std::thread::hardware_concurrency();
+            if (cores < 2 || taskCount < MinParallelTasks) {
+                return 0;
+            }
+
+            // The calling thread consumes the results, so it keeps one core
+            return std::min(cores - 1, taskCount);
+        }
+
+        /// @brief Produces the results of tasks on worker threads, and consumes them in task order on the calling thread
+        /// @note Results are passed through slots: produce(task, slot) stores the result of a task in a slot,
+        /// and consume(task, slot) reads it, after which the slot is reused. Workers only run up to slotCount tasks
+        /// ahead of the calling thread, which bounds the memory held by results. With no workers, both run on the
+        /// calling thread, one task after the other, with slot 0.
+        /// An exception thrown by produce or consume stops the other tasks like a failure, and is rethrown on the
+        /// calling thread once every worker is joined.
+        /// @param slotCount The number of slots, at least 1 (see getSlotCount)
+        /// @return False as soon as produce or consume returns false, in which case the other tasks are skipped
+        template<typename Produce, typename Consume>
+        bool runOrdered(size_t taskCount, size_t workerCount, size_t slotCount, Produce produce, Consume consume) {
+            if (workerCount == 0) {
+                for (size_t task = 0; task < taskCount; task++) {
+                    if (!produce(task, 0) || !consume(task, 0)) {
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+            std::mutex mutex;
+            std::condition_variable producedCondition;
+            std::condition_variable consumedCondition;
+            std::vector<bool> ready(slotCount);
+            size_t nextTask = 0;
+            size_t consumedCount = 0;
+            bool failed = false;
+            std::exception_ptr error; // First exception thrown by a task
+
+            auto work = [&]() {
+                std::unique_lock<std::mutex> lock(mutex);
+                while (true) {
+                    consumedCondition.wait(lock, [&]() {
+                        return failed || nextTask >= taskCount || nextTask < consumedCount + slotCount;
+                    });
+                    if (failed || nextTask >= taskCount) {
+                        return;
+                    }
+
+                    size_t task = nextTask++;
+                    lock.unlock();
+                    bool success = false;
+                    std::exception_ptr taskError;
+                    try {
+                        success = produce(task, task % slotCount);
+                    } catch (...) {
+                        // Escaping the thread would terminate the program
+                        taskError = std::current_exception();
+                    }
+                    lock.lock();
+
+                    if (success) {
+                        ready[task % slotCount] = true;
+                    } else {
+                        failed = true;
+                        if (taskError && !error) {
+                            error = taskError;
+                        }
+                        consumedCondition.notify_all();
+                    }
+                    producedCondition.notify_one();
+                }
+            };
+
+            // Every started worker has to be joined before leaving, even when the calling thread throws
+            std::vector<std::thread> workers;
+            try {
+                workers.reserve(workerCount);
+                for (size_t i = 0; i < workerCount; i++) {
+                    workers.emplace_back(work);
+                }
+
+                for (size_t task = 0; task < taskCount; task++) {
+                    {
+                        std::unique_lock<std::mutex> lock(mutex);
+                        producedCondition.wait(lock, [&]() { return failed || ready[task % slotCount]; });
+                        if (failed) {
+                            break;
+                        }
+                    }
+
+                    bool success = consume(task, task % slotCount);
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        ready[task % slotCount] = false;
+                        consumedCount++;
+                        failed |= !success;
+                    }
+                    consumedCondition.notify_all();
+                }
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!error) {
+                    error = std::current_exception();
+                }
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                failed |= consumedCount < taskCount;
+            }
+            consumedCondition.notify_all();
+            for (auto &worker : workers) {
+                worker.join();
+            }
+            if (error) {
+                std::rethrow_exception(error);
+            }
+            return !failed;
+        }
+
+        /// @brief Returns the number of result slots for runOrdered with the specified number of workers
+        inline size_t getSlotCount(size_t workerCount) {
+            return std::max<size_t>(workerCount * ResultsPerWorker, 1);
+        }
+    }
+
+}
@@ -1,21 +1,140 @@
 #include <zephyrus.hpp>
 
 #include <iostream>
+#include <utility>
 
 namespace zephyrus {
+    Zephyrus::Zephyrus(Zephyrus &&other) noexcept :
+            m_state(other.m_state),
+            m_fixMode(other.m_fixMode),
+            m_frame(other.m_frame),
+            m_macro(std::move(other.m_macro)),
+            m_sharedMacro(std::move(other.m_sharedMacro)),
+            m_handleButtonMethod(std::move(other.m_handleButtonMethod)),
+            m_fixPlayerMethod(std::move(other.m_fixPlayerMethod)),
+            m_requestMacroFixMethod(std::move(other.m_requestMacroFixMethod)),
+            m_getFrameMethod(std::move(other.m_getFrameMethod)),
+            m_cursor(getMacro(), m_frame), // Not copied, it points at the macro of the other bot
+            m_stream(std::move(other.m_stream)),
+            m_streamStep(std::move(other.m_streamStep)),
+            m_playbackStats(other.m_playbackStats) {
+        other.m_macro.clearFrames(); // A moved-from macro is only valid once it is cleared
+        other.m_cursor = Macro::PlaybackCursor(other.m_macro, other.m_frame);
+    }
+
+    Zephyrus &Zephyrus::operator=(Zephyrus &&other) {
+        if (this != &other) {
+            m_state = other.m_state;
+            m_fixMode = other.m_fixMode;
+            m_frame = other.m_frame;
+            m_macro = std::move(other.m_macro);
+            m_sharedMacro = std::move(other.m_sharedMacro);
+            m_handleButtonMethod = std::move(other.m_handleButtonMethod);
+            m_fixPlayerMethod = std::move(other.m_fixPlayerMethod);
+            m_requestMacroFixMethod = std::move(other.m_requestMacroFixMethod);
+            m_getFrameMethod = std::move(other.m_getFrameMethod);
+            m_cursor = Macro::PlaybackCursor(getMacro(), m_frame);
+            m_stream = std::move(other.m_stream);
+            m_streamStep = std::move(other.m_streamStep);
+            m_playbackStats = other.m_playbackStats;
+            other.m_macro.clearFrames(); // A moved-from macro is only valid once it is cleared
+            other.m_cursor = Macro::PlaybackCursor(other.m_macro, other.m_frame);
+        }
+        return *this;
+    }
+
     void Zephyrus::setState(BotState state) {
         m_state = state;
+        if (m_state == BotState::Playing) {
+            seekPlayback(m_frame);
+        }
+    }
+
+    void Zephyrus::seekPlayback(uint32_t frame) {
+        if (m_stream) {
+            m_stream->seek(frame);
+        } else {
+            m_cursor.seek(frame);
+        }
+        m_playbackStats.seeks++;
+    }
+
+    bool Zephyrus::streamMacro(const std::filesystem::path &path, size_t capacity) {
+        auto stream = std::make_unique<MacroStream>(capacity);
+        if (!stream->open(path)) {
+            return false;
+        }
+
+        stream->seek(m_frame);
+        m_stream = std::move(stream);
+        m_streamStep.reserve();
+        return true;
+    }
+
+    void Zephyrus::setMacro(const Macro &macro) {
+        m_sharedMacro.reset();
+        m_stream.reset();
+        m_macro = macro;
+        m_cursor = Macro::PlaybackCursor(m_macro, m_frame);
+    }
+
+    void Zephyrus::setMacro(Macro &&macro) {
+        m_sharedMacro.reset();
+        m_stream.reset();
+        m_macro = std::move(macro);
+        m_cursor = Macro::PlaybackCursor(m_macro, m_frame);
+    }
+
+    void Zephyrus::setMacro(std::shared_ptr<const Macro> macro) {
+        if (!macro) return setMacro(Macro());
+
+        m_sharedMacro = std::move(macro);
+        m_stream.reset();
+        m_macro = Macro();
+        m_cursor = Macro::PlaybackCursor(*m_sharedMacro, m_frame);
+    }
+
+    Macro &Zephyrus::editMacro() {
+        if (m_sharedMacro) {
+            // Copy on write, the shared macro might be used by someone else
+            m_macro = *m_sharedMacro;
+            m_sharedMacro.reset();
+            m_cursor = Macro::PlaybackCursor(m_macro, m_frame);
+        }
+        return m_macro;
+    }
+
+    Macro Zephyrus::takeMacro() {
+        if (m_sharedMacro) {
+            Macro macro = *m_sharedMacro;
+            setMacro(Macro());
+            return macro;
+        }
+
+        // Move construct, so that the macro keeps its memory resource
+        Macro macro(std::move(m_macro));
+        setMacro(Macro());
+        return macro;
+    }
+
+    std::shared_ptr<const Macro> Zephyrus::shareMacro() {
+        if (!m_sharedMacro) {
+            m_sharedMacro = std::make_shared<const Macro>(std::move(m_macro));
+            m_macro = Macro();
+            m_cursor = Macro::PlaybackCursor(*m_sharedMacro, m_frame);
+        }
+        return m_sharedMacro;
     }
 
     void Zephyrus::PlayerObjectPushButton(int playerIndex, int buttonIndex) {
         if (m_state == BotState::Recording) {
-            m_macro.addFrame(m_frame, playerIndex, static_cast<PlayerButton>(buttonIndex), true);
+            editMacro().addFrame(m_frame, playerIndex, static_cast<PlayerButton>(buttonIndex), true);
         }
     }
 
     void Zephyrus::PlayerObjectReleaseButton(int playerIndex, int buttonIndex) {
         if (m_state == BotState::Recording) {
-            m_macro.addFrame(m_frame, playerIndex, static_cast<PlayerButton>(buttonIndex), false);
+            editMacro().addFrame(m_frame, playerIndex, static_cast<PlayerButton>(buttonIndex), false);
         }
     }
 
@@ -24,34 +143,56 @@ namespace zephyrus {
         if (frame == m_frame) return;
 
         uint32_t oldFrame = m_frame;
-        uint32_t frameDiff = frame - m_frame;
         m_frame = frame;
 
         if (m_state == BotState::Playing) {
-            auto frames = frameDiff > 1 ? // If the frame difference is greater than 1
-                    m_macro.getFrames(oldFrame + 1, m_frame) : // Get all frames between the last frame and the current frame
-                    m_macro.getFrames(m_frame); // Get only the current frame
-            for (const auto &f: frames) {
-                m_handleButtonMethod(
-                        f.isSecondPlayer() ? 1 : 0,
-                        static_cast<int>(f.getButton()),
-                        f.isPressed());
+            if (m_frame < oldFrame) {
+                m_playbackStats.seeks++;
             }
 
-            if (m_fixMode == BotFixMode::EveryFrame || (m_fixMode == BotFixMode::EveryAction && !frames.empty())) {
-                auto frameFixes = m_macro.getFrameFixes(m_frame);
-                for (const auto &f: frameFixes) {
-                    m_fixPlayerMethod(0, f.getPlayer1());
-                    if (f.player2Exists())
-                        m_fixPlayerMethod(1, f.getPlayer2());
+            auto dispatch = [this](const auto &frames, const auto &frameFixes) {
+                m_playbackStats.ticks++;
+                m_playbackStats.entriesVisited += frames.size() + frameFixes.size();
+
+                for (const auto &f: frames) {
+                    m_handleButtonMethod(
+                            f.isSecondPlayer() ? 1 : 0,
+                            static_cast<int>(f.getButton()),
+                            f.isPressed());
+                }
+                m_playbackStats.actionsDispatched += frames.size();
+
+                if (m_fixMode == BotFixMode::EveryFrame || (m_fixMode == BotFixMode::EveryAction && !frames.empty())) {
+                    for (const auto &f: frameFixes) {
+                        // Frame fixes for frames we did not stop on are skipped
+                        if (f.getFrame() != m_frame) continue;
+
+                        m_fixPlayerMethod(0, f.getPlayer1());
+                        if (f.player2Exists())
+                            m_fixPlayerMethod(1, f.getPlayer2());
+                        m_playbackStats.fixesApplied++;
+                    }
+                }
+            };
+
+            if (m_stream) {
+                // Never waits for the disk, entries that are not decoded yet come with a later tick
+                if (!m_stream->advance(m_frame, m_streamStep)) {
+                    m_playbackStats.underruns++;
                 }
+                dispatch(m_streamStep.frames, m_streamStep.frameFixes);
+            } else {
+                // The cursor only moves forward, so this is amortized O(1) per tick, and it returns views
+                // into the macro, so there is no buffer that could grow
+                auto step = m_cursor.advance(m_frame);
+                dispatch(step.frames, step.frameFixes);
             }
         } else if (m_state == BotState::Recording) {
              Macro::FrameFix playerData = m_requestMacroFixMethod();
              if (playerData.player2Exists()) {
-                 m_macro.addFrameFix(m_frame, playerData.getPlayer1(), playerData.getPlayer2());
+                 editMacro().addFrameFix(m_frame, playerData.getPlayer1(), playerData.getPlayer2());
              } else {
-                 m_macro.addFrameFix(m_frame, playerData.getPlayer1());
+                 editMacro().addFrameFix(m_frame, playerData.getPlayer1());
              }
         }
     }
@@ -61,7 +202,10 @@ namespace zephyrus {
 
         if (m_state == BotState::Recording) {
             // Remove everything past the current frame
-            m_macro.clearFrames(frame);
+            editMacro().clearFrames(frame);
+        } else if (m_state == BotState::Playing) {
+            // Continue playing from the respawn point
+            seekPlayback(frame);
         }
     }
 }
\ No newline at end of file
@@ -0,0 +1,39 @@
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "block-codec.hpp"
+#include "check.hpp"
+
+namespace {
+    using namespace zephyrus;
+
+    bool roundTrip(const std::vector<uint8_t> &data) {
+        std::vector<uint8_t> compressed;
+        BlockCodec::compress(data.data(), data.size(), compressed);
+        std::vector<uint8_t> output(data.size());
+        return BlockCodec::decompress(compressed.data(), compressed.size(), output.data(), output.size()) &&
+               output == data;
+    }
+}
+
+int main() {
+    // A match shorter than the 8 byte period of a 1 byte offset, far enough from the end for the fast path
+    std::vector<uint8_t> block = {0x10, 'a', 0x01, 0x00, 0xF0, 40 - 15};
+    block.insert(block.end(), 40, 'b');
+    std::vector<uint8_t> output(1 + 4 + 40);
+    ZEPHYRUS_CHECK(BlockCodec::decompress(block.data(), block.size(), output.data(), output.size()));
+    ZEPHYRUS_CHECK(std::memcmp(output.data(), "aaaaa", 5) == 0);
+    ZEPHYRUS_CHECK(output[5] == 'b' && output.back() == 'b');
+
+    // Periodic data of every short period, which takes the byte by byte pattern copy
+    std::mt19937 random(1);
+    for (size_t period = 1; period <= 16; period++) {
+        std::vector<uint8_t> data;
+        for (size_t i = 0; i < 4096; i++) {
+            data.push_back(i % 97 < 50 ? uint8_t(i % period) : uint8_t(random()));
+        }
+        ZEPHYRUS_CHECK(roundTrip(data));
+    }
+    return 0;
+}
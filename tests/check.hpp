@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+
+/// @brief Stops the test with the failed condition and its location unless the condition holds
+#define ZEPHYRUS_CHECK(condition)                                                               \
+    do {                                                                                        \
+        if (!(condition)) {                                                                     \
+            std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            std::exit(1);                                                                       \
+        }                                                                                       \
+    } while (false)
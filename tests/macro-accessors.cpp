@@ -0,0 +1,36 @@
+#include <zephyrus.hpp>
+
+#include "check.hpp"
+
+int main() {
+    using namespace zephyrus;
+
+    Macro macro;
+    for (uint32_t frame = 1; frame <= 100; frame++) {
+        macro.addFrame(frame, false, PlayerButton::Jump, frame % 2 == 1);
+        if (frame % 10 == 0) {
+            macro.addFrameFix(frame, {float(frame), 0.f, 0.0, 0.f}, {float(frame), 1.f, 1.0, 1.f});
+        } else {
+            macro.addFrameFix(frame, {float(frame), 0.f, 0.0, 0.f});
+        }
+    }
+
+    // Views do not copy, and code written against the former std::vector accessors keeps compiling
+    auto frames = macro.getFrames();
+    ZEPHYRUS_CHECK(frames.size() == 100 && frames.front().getFrame() == 1 && frames.back().getFrame() == 100);
+    const std::vector<Macro::Frame> &frameVector = macro.getFrames();
+    std::vector<Macro::Frame> frameCopy = macro.getFrames();
+    ZEPHYRUS_CHECK(frameVector.size() == 100 && frameCopy.size() == 100);
+    ZEPHYRUS_CHECK(frameCopy[41].getFrame() == 42 && frameCopy[41].getFlags() == frames[41].getFlags());
+
+    const auto &frameFixes = macro.getFrameFixes();
+    std::vector<Macro::FrameFix> frameFixVector = macro.getFrameFixes();
+    ZEPHYRUS_CHECK(frameFixVector.size() == frameFixes.size());
+    for (size_t i = 0; i < frameFixVector.size(); i++) {
+        ZEPHYRUS_CHECK(frameFixVector[i].getFrame() == i + 1);
+        ZEPHYRUS_CHECK(frameFixVector[i].getPlayer1().x == float(i + 1));
+        ZEPHYRUS_CHECK(frameFixVector[i].player2Exists() == ((i + 1) % 10 == 0));
+    }
+    ZEPHYRUS_CHECK(macro.getFrameFixes(10, 19).size() == 10);
+    return 0;
+}
@@ -0,0 +1,55 @@
+#include <stdexcept>
+#include <vector>
+
+#include "check.hpp"
+#include "parallel.hpp"
+
+namespace {
+    using namespace zephyrus;
+
+    constexpr size_t TaskCount = 1000;
+    constexpr size_t WorkerCount = 3;
+
+    /// @brief Runs the tasks with results of task * 2, throwing from the producer or the consumer of one task
+    /// @return Whether the exception reached the calling thread
+    bool throws(size_t produceThrow, size_t consumeThrow) {
+        std::vector<size_t> slots(Parallel::getSlotCount(WorkerCount));
+        try {
+            Parallel::runOrdered(TaskCount, WorkerCount, slots.size(), [&](size_t task, size_t slot) {
+                if (task == produceThrow) throw std::runtime_error("produce");
+                slots[slot] = task * 2;
+                return true;
+            }, [&](size_t task, size_t slot) {
+                if (task == consumeThrow) throw std::runtime_error("consume");
+                return slots[slot] == task * 2;
+            });
+        } catch (const std::runtime_error &) {
+            return true;
+        }
+        return false;
+    }
+}
+
+int main() {
+    // Results are consumed in order, with and without workers
+    for (size_t workerCount : {size_t(0), WorkerCount}) {
+        std::vector<size_t> slots(Parallel::getSlotCount(workerCount));
+        std::vector<size_t> consumed;
+        ZEPHYRUS_CHECK(Parallel::runOrdered(TaskCount, workerCount, slots.size(), [&](size_t task, size_t slot) {
+            slots[slot] = task * 2;
+            return true;
+        }, [&](size_t task, size_t slot) {
+            consumed.push_back(slots[slot] / 2);
+            return consumed.back() == task;
+        }));
+        ZEPHYRUS_CHECK(consumed.size() == TaskCount);
+    }
+
+    // Exceptions thrown on a worker or on the calling thread stop every task and reach the caller
+    ZEPHYRUS_CHECK(throws(0, TaskCount));
+    ZEPHYRUS_CHECK(throws(TaskCount / 2, TaskCount));
+    ZEPHYRUS_CHECK(throws(TaskCount, 0));
+    ZEPHYRUS_CHECK(throws(TaskCount, TaskCount - 1));
+    ZEPHYRUS_CHECK(!throws(TaskCount, TaskCount));
+    return 0;
+}
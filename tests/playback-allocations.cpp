@@ -0,0 +1,98 @@
+#include <zephyrus.hpp>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "check.hpp"
+
+// Counts the allocations made by the thread that plays the macro, the stream thread is free to allocate
+namespace {
+    thread_local bool counting = false;
+    std::atomic<size_t> allocationCount{0};
+}
+
+void *operator new(size_t size) {
+    if (counting) {
+        allocationCount.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (void *memory = std::malloc(size ? size : 1)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *memory) noexcept { std::free(memory); }
+
+void operator delete(void *memory, size_t) noexcept { std::free(memory); }
+
+namespace {
+    using namespace zephyrus;
+
+    constexpr uint32_t FrameCount = 20000;
+
+    Macro makeMacro() {
+        Macro macro;
+        for (uint32_t frame = 1; frame <= FrameCount; frame++) {
+            if (frame % 7 == 0) {
+                macro.addFrame(frame, frame % 2 == 0, PlayerButton::Jump, frame % 14 == 0);
+            }
+            // Skip a few frames, so that the dense fix track has gaps
+            if (frame % 1000 != 0) {
+                macro.addFrameFix(frame, {float(frame), 1.f, 2.f, 3.f});
+            }
+        }
+        return macro;
+    }
+
+    /// @brief Plays every frame, then respawns once and plays the second half again
+    /// @return The number of allocations made by the ticks
+    size_t play(Zephyrus &bot, uint32_t &frame, size_t &handled) {
+        bot.setHandleButtonMethod([&handled](int, int, bool) { handled++; });
+        bot.setFixPlayerMethod([&handled](int, Macro::FrameFix::PlayerData) { handled++; });
+        bot.setGetFrameMethod([&frame]() { return frame; });
+        bot.setFixMode(BotFixMode::EveryFrame);
+        bot.setState(BotState::Playing);
+
+        allocationCount = 0;
+        counting = true;
+        for (frame = 1; frame <= FrameCount; frame++) {
+            bot.GJBaseGameLayerProcessCommands();
+        }
+        frame = FrameCount / 2;
+        bot.PlayLayerResetLevel();
+        for (; frame <= FrameCount; frame++) {
+            bot.GJBaseGameLayerProcessCommands();
+        }
+        counting = false;
+        return allocationCount;
+    }
+}
+
+int main() {
+    Macro macro = makeMacro();
+
+    // In-memory playback
+    {
+        Zephyrus bot;
+        uint32_t frame = 0;
+        size_t handled = 0;
+        bot.setMacro(macro);
+        ZEPHYRUS_CHECK(play(bot, frame, handled) == 0);
+        ZEPHYRUS_CHECK(handled > 0);
+    }
+
+    // Streamed playback, entries that are not decoded in time are late but never allocate
+    auto path = std::filesystem::temp_directory_path() / "zephyrus-playback-allocations.zr";
+    ZEPHYRUS_CHECK(writeToFile(macro, path, 3));
+    {
+        Zephyrus bot;
+        uint32_t frame = 0;
+        size_t handled = 0;
+        ZEPHYRUS_CHECK(bot.streamMacro(path));
+        ZEPHYRUS_CHECK(play(bot, frame, handled) == 0);
+        ZEPHYRUS_CHECK(handled > 0);
+    }
+    std::filesystem::remove(path);
+    return 0;
+}
@@ -0,0 +1,86 @@
+#include <zephyrus.hpp>
+
+#include <random>
+
+#include "check.hpp"
+
+namespace {
+    using namespace zephyrus;
+
+    bool equal(const Macro::FrameFix &a, const Macro::FrameFix &b) {
+        return a.getFrame() == b.getFrame() && a.getPlayer1().x == b.getPlayer1().x &&
+               a.player2Exists() == b.player2Exists() && (!a.player2Exists() || a.getPlayer2().x == b.getPlayer2().x);
+    }
+
+    /// @brief Records fixes on most frames, with gaps of up to maxGap frames and player 2 data on some of them
+    Macro makeMacro(std::mt19937 &random, uint32_t maxGap, bool sparse) {
+        Macro macro;
+        uint32_t frame = 1 + random() % 100;
+        for (int i = 0; i < 20000; i++) {
+            frame += random() % 8 == 0 ? 1 + random() % maxGap : 1;
+            Macro::FrameFix::PlayerData player{float(i), 0.f, 0.0, 0.f};
+            if (random() % 5 == 0) {
+                macro.addFrameFix(frame, player, {-float(i), 0.f, 0.0, 0.f});
+            } else {
+                macro.addFrameFix(frame, player);
+            }
+            if (random() % 13 == 0) {
+                macro.addFrame(frame, false, PlayerButton::Jump, true);
+            }
+        }
+        if (sparse) {
+            // A second fix on the same frame leaves dense mode
+            macro.addFrameFix(frame, {0.f, 0.f, 0.0, 0.f});
+        }
+        return macro;
+    }
+
+    void check(const Macro &macro, std::mt19937 &random) {
+        const auto &frameFixes = macro.getFrameFixes();
+
+        // Walking the iterator gives the same fixes as indexing
+        size_t index = 0;
+        for (auto it = frameFixes.begin(); it != frameFixes.end(); ++it, index++) {
+            ZEPHYRUS_CHECK(it.getIndex() == index);
+            ZEPHYRUS_CHECK(equal(*it, frameFixes[index]));
+        }
+        ZEPHYRUS_CHECK(index == frameFixes.size());
+
+        // Advancing by random steps (with a few seeks) passes exactly the fixes of each step
+        uint32_t last = frameFixes.back().getFrame();
+        Macro::PlaybackCursor cursor(macro);
+        uint32_t frame = 0;
+        uint32_t first = 0; // First frame whose fixes were not returned yet
+        while (frame <= last + 10) {
+            if (random() % 100 == 0) {
+                // Fixes on the frame of a seek come with the next advance
+                frame = random() % (last + 10);
+                first = frame;
+                cursor.seek(frame);
+                continue;
+            }
+            frame += random() % 30;
+
+            auto step = cursor.advance(frame);
+            auto expected = macro.getFrameFixesView(first, frame);
+            first = frame + 1;
+            ZEPHYRUS_CHECK(step.frameFixes.size() == expected.size());
+            auto it = expected.begin();
+            for (const auto &frameFix : step.frameFixes) {
+                ZEPHYRUS_CHECK(equal(frameFix, *it++));
+            }
+        }
+    }
+}
+
+int main() {
+    std::mt19937 random(1);
+    for (uint32_t maxGap : {1u, 7u, 200u}) {
+        for (bool sparse : {false, true}) {
+            Macro macro = makeMacro(random, maxGap, sparse);
+            ZEPHYRUS_CHECK(macro.getFrameFixes().isDense() == (!sparse && maxGap < 200));
+            check(macro, random);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,36 @@
+#include <zephyrus.hpp>
+
+#include "check.hpp"
+
+int main() {
+    using namespace zephyrus;
+
+    Macro macro;
+    macro.addFrame(10, false, PlayerButton::Jump, true);
+    macro.addFrameFix(10, {1.f, 2.f, 3.f, 4.f});
+
+    auto path = std::filesystem::temp_directory_path() / "zephyrus-write-versions.zr";
+    std::filesystem::remove(path);
+
+    // Only the versions that readers support are written
+    for (uint8_t version : {0, 1, 4, 255}) {
+        ZEPHYRUS_CHECK(!writeToFile(macro, path, version));
+        ZEPHYRUS_CHECK(!std::filesystem::exists(path));
+    }
+
+    // Version 2 has no chunks to compress
+    ZEPHYRUS_CHECK(!writeToFile(macro, path, 2, MacroFileCodec::LZ));
+    ZEPHYRUS_CHECK(!std::filesystem::exists(path));
+    ZEPHYRUS_CHECK(writeToFile(macro, path, 3, MacroFileCodec::LZ));
+
+    for (uint8_t version : {2, 3}) {
+        Macro read;
+        ZEPHYRUS_CHECK(writeToFile(macro, path, version));
+        ZEPHYRUS_CHECK(readFromFile(path, read));
+        ZEPHYRUS_CHECK(read.getFrames().size() == 1);
+        ZEPHYRUS_CHECK(read.getFrameFixes().size() == 1);
+    }
+
+    std::filesystem::remove(path);
+    return 0;
+}